@@ -0,0 +1,389 @@
+#ifndef M6502_ASYNC_H
+#define M6502_ASYNC_H
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "cM6502.h"
+
+// A CPU and its memory running on their own thread.
+//
+// The host sends commands through one single producer, single consumer
+// queue and polls events from another, neither of them locks. Commands are
+// taken in order. Run commands are executed in frames of FrameCycles, the
+// commands after a RUN are taken between its frames.
+//
+// After every frame the emulation thread copies CPU and memory into the
+// back one of two views and makes it the front one. The host pins the front
+// view with Read() while it looks at it. When the host still holds the back
+// view the copy is skipped rather than waited for, so the emulation thread
+// never blocks on the host. A SNAPSHOT that finds the back view held stays
+// pending, its event comes with the next view that gets published.
+
+namespace M6502
+{
+    using u64 = unsigned long long;
+    template<typename T, size_t CAPACITY> struct SPSCQueue;
+    template<typename CPUType = CPU> struct AsyncCPU;
+}
+
+template<typename T, size_t CAPACITY>
+struct M6502::SPSCQueue{
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "CAPACITY must be a power of two");
+
+    // producer side
+    bool Push(const T& value)
+    {
+        size_t tail = Tail.load(std::memory_order_relaxed);
+        if(tail - Head.load(std::memory_order_acquire) == CAPACITY){
+            return false;
+        }
+        Items[tail & (CAPACITY - 1)] = value;
+        Tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer side
+    bool Pop(T& value)
+    {
+        size_t head = Head.load(std::memory_order_relaxed);
+        if(head == Tail.load(std::memory_order_acquire)){
+            return false;
+        }
+        value = Items[head & (CAPACITY - 1)];
+        Head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    T Items[CAPACITY];
+    // on their own cache lines, one is written by each side
+    alignas(64) std::atomic<size_t> Head{0};
+    alignas(64) std::atomic<size_t> Tail{0};
+};
+
+template<typename CPUType>
+struct M6502::AsyncCPU{
+    using MemType = typename CPUType::MemoryType;
+
+    struct Command{
+        enum Kind{
+            RUN, STOP, POKE, IRQ, NMI, SNAPSHOT, BREAK, CLEAR_BREAK, QUIT
+        };
+        Kind Type = STOP;
+        int Cycles = 0;
+        u16 Address = 0;
+        u8 Value = 0;
+    };
+
+    struct Event{
+        enum Kind{
+            STOPPED,    // a run used up its cycles or was stopped
+            BREAKPOINT, // PC reached a breakpoint, the run is stopped
+            HALTED,     // the CPU halted, the run is stopped
+            FRAME,      // a frame of a run completed
+            SNAPSHOT    // a view was published for a SNAPSHOT command
+        };
+        Kind Type = STOPPED;
+        u16 PC = 0;
+        u64 Frame = 0;
+        u64 Cycles = 0;
+    };
+
+    struct View{
+        CPUType CPU;
+        MemType Mem;
+        u64 Frame = 0;
+        u64 Cycles = 0;
+        std::atomic<int> Readers{0};
+    };
+
+    // pins a view while it is alive
+    class ReadView{
+    public:
+        explicit ReadView(View* view) : view(view)
+        {
+        }
+
+        ReadView(ReadView&& other) : view(other.view)
+        {
+            other.view = nullptr;
+        }
+
+        ReadView(const ReadView&) = delete;
+        ReadView& operator=(const ReadView&) = delete;
+
+        ~ReadView()
+        {
+            if(view){
+                view->Readers--;
+            }
+        }
+
+        const View* operator->() const
+        {
+            return view;
+        }
+
+        const View& operator*() const
+        {
+            return *view;
+        }
+
+    private:
+        View* view;
+    };
+
+    const int FrameCycles;
+    // events lost because the host did not poll
+    std::atomic<u64> DroppedEvents{0};
+    // views not published because the host held the back one
+    std::atomic<u64> SkippedViews{0};
+
+    AsyncCPU(const CPUType& cpu, const MemType& mem, int frameCycles = 20000)
+        : FrameCycles(frameCycles), cpu(cpu), mem(new MemType(mem)), breakpoints(0x10000)
+    {
+        for(View& view : views){
+            view.CPU = cpu;
+            view.Mem = mem;
+        }
+        thread = std::thread(&AsyncCPU::Loop, this);
+    }
+
+    AsyncCPU(const AsyncCPU&) = delete;
+    AsyncCPU& operator=(const AsyncCPU&) = delete;
+
+    ~AsyncCPU()
+    {
+        while(!Send({Command::QUIT})){
+            std::this_thread::yield();
+        }
+        thread.join();
+    }
+
+    bool Send(const Command& command)
+    {
+        return commands.Push(command);
+    }
+
+    bool Run(int cycles)
+    {
+        return Send({Command::RUN, cycles});
+    }
+
+    bool Stop()
+    {
+        return Send({Command::STOP});
+    }
+
+    bool Poke(u16 address, u8 value)
+    {
+        return Send({Command::POKE, 0, address, value});
+    }
+
+    bool IRQ()
+    {
+        return Send({Command::IRQ});
+    }
+
+    bool NMI()
+    {
+        return Send({Command::NMI});
+    }
+
+    bool Snapshot()
+    {
+        return Send({Command::SNAPSHOT});
+    }
+
+    bool Break(u16 address)
+    {
+        return Send({Command::BREAK, 0, address});
+    }
+
+    bool ClearBreak(u16 address)
+    {
+        return Send({Command::CLEAR_BREAK, 0, address});
+    }
+
+    bool Poll(Event& event)
+    {
+        return events.Pop(event);
+    }
+
+    // the latest published CPU and memory, stays unchanged while pinned
+    ReadView Read()
+    {
+        while(true){
+            int index = front.load();
+            views[index].Readers++;
+            if(front.load() == index){
+                return ReadView(&views[index]);
+            }
+            views[index].Readers--;
+        }
+    }
+
+private:
+    SPSCQueue<Command, 1024> commands;
+    SPSCQueue<Event, 1024> events;
+    View views[2];
+    std::atomic<int> front{0};
+
+    // owned by the emulation thread
+    CPUType cpu;
+    std::unique_ptr<MemType> mem;
+    std::vector<bool> breakpoints;
+    int breakpointCount = 0;
+    long long remaining = 0;
+    u64 frame = 0;
+    u64 cycles = 0;
+    bool pendingSnapshot = false;
+
+    std::thread thread;
+
+    void Emit(typename Event::Kind type)
+    {
+        if(!events.Push({type, cpu.PC, frame, cycles})){
+            DroppedEvents++;
+        }
+    }
+
+    bool Publish()
+    {
+        int back = 1 - front.load();
+        View& view = views[back];
+        if(view.Readers.load() != 0){
+            SkippedViews++;
+            return false;
+        }
+        view.CPU = cpu;
+        view.Mem = *mem;
+        view.Frame = frame;
+        view.Cycles = cycles;
+        front.store(back);
+        if(pendingSnapshot){
+            pendingSnapshot = false;
+            Emit(Event::SNAPSHOT);
+        }
+        return true;
+    }
+
+    void EndRun(typename Event::Kind type)
+    {
+        remaining = 0;
+        Publish();
+        Emit(type);
+    }
+
+    // false on QUIT
+    bool Handle(const Command& command)
+    {
+        switch(command.Type){
+            case Command::RUN:
+                remaining += command.Cycles;
+                break;
+            case Command::STOP:
+                if(remaining > 0){
+                    EndRun(Event::STOPPED);
+                }
+                break;
+            case Command::POKE:
+                (*mem)[command.Address] = command.Value;
+                break;
+            case Command::IRQ:
+                cycles += cpu.IRQ(*mem);
+                break;
+            case Command::NMI:
+                cycles += cpu.NMI(*mem);
+                break;
+            case Command::SNAPSHOT:
+                pendingSnapshot = true;
+                Publish();
+                break;
+            case Command::BREAK:
+                breakpointCount += !breakpoints[command.Address];
+                breakpoints[command.Address] = true;
+                break;
+            case Command::CLEAR_BREAK:
+                breakpointCount -= breakpoints[command.Address];
+                breakpoints[command.Address] = false;
+                break;
+            case Command::QUIT:
+                return false;
+        }
+        return true;
+    }
+
+    bool HandleCommands()
+    {
+        Command command;
+        while(commands.Pop(command)){
+            if(!Handle(command)){
+                return false;
+            }
+            if(command.Type == Command::RUN){
+                break;
+            }
+        }
+        return true;
+    }
+
+    // one instruction at a time, stops after reaching a breakpoint
+    int Step(int budget, bool& hit)
+    {
+        int used = 0;
+        while(used < budget && !cpu.Halted){
+            used += cpu.Execute(1, *mem);
+            if(breakpoints[cpu.PC]){
+                hit = true;
+                break;
+            }
+        }
+        return used;
+    }
+
+    void RunFrame()
+    {
+        int budget = static_cast<int>(std::min<long long>(remaining, FrameCycles));
+        bool hit = false;
+        int used = breakpointCount > 0 ? Step(budget, hit) : cpu.Execute(budget, *mem);
+        cycles += used;
+        remaining -= used;
+        frame++;
+        if(hit){
+            EndRun(Event::BREAKPOINT);
+        }else if(cpu.Halted){
+            EndRun(Event::HALTED);
+        }else{
+            Publish();
+            Emit(Event::FRAME);
+            if(remaining <= 0){
+                EndRun(Event::STOPPED);
+            }
+        }
+    }
+
+    void Loop()
+    {
+        int idle = 0;
+        while(HandleCommands()){
+            if(remaining > 0){
+                RunFrame();
+                idle = 0;
+                continue;
+            }
+            if(pendingSnapshot){
+                Publish();
+            }
+            if(++idle < 64){
+                std::this_thread::yield();
+            }else{
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        }
+    }
+};
+#endif
@@ -0,0 +1,226 @@
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include "gtest/gtest.h"
+#include "M6502Async.h"
+#include "M6502Workloads.h"
+
+namespace
+{
+    // counts X up for ever, with an IRQ handler at $0300 counting interrupts at $20
+    constexpr M6502::u8 CountProgram[] = {
+        0x58,               // 0200 CLI
+        0xA2, 0x00,         // 0201 LDX #$00
+        // loop
+        0xE8,               // 0203 INX
+        0x86, 0x10,         // 0204 STX $10
+        0x4C, 0x03, 0x02,   // 0206 JMP $0203
+    };
+    constexpr M6502::u8 IRQHandler[] = {
+        0xE6, 0x20,         // 0300 INC $20
+        0x40,               // 0302 RTI
+    };
+}
+
+class M6502AsyncTest : public testing::Test
+{
+public:
+    using AsyncCPU = M6502::AsyncCPU<M6502::CPU>;
+    using Event = AsyncCPU::Event;
+
+    std::unique_ptr<M6502::Mem> mem{new M6502::Mem};
+    M6502::CPU cpu;
+
+    void LoadCountProgram()
+    {
+        cpu.Reset(*mem);
+        memcpy(mem->data + 0x0200, CountProgram, sizeof(CountProgram));
+        memcpy(mem->data + 0x0300, IRQHandler, sizeof(IRQHandler));
+        (*mem)[0xFFFE] = 0x00;
+        (*mem)[0xFFFF] = 0x03;
+        cpu.PC = 0x0200;
+    }
+
+    // polls until an event that ends a run, or a snapshot when asked for,
+    // counting frames on the way
+    static Event WaitForEnd(AsyncCPU& async, int* frames = nullptr, bool snapshot = false)
+    {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        Event event;
+        while(std::chrono::steady_clock::now() < deadline){
+            if(!async.Poll(event)){
+                std::this_thread::yield();
+                continue;
+            }
+            if(event.Type == Event::FRAME){
+                if(frames){
+                    (*frames)++;
+                }
+                continue;
+            }
+            if((event.Type == Event::SNAPSHOT) == snapshot){
+                return event;
+            }
+        }
+        ADD_FAILURE() << "no event within 10 seconds";
+        return event;
+    }
+};
+
+TEST_F(M6502AsyncTest, RunEndsInTheSameStateAsPlainExecution)
+{
+    // given:
+    const M6502::Workload& workload = M6502::BenchmarkWorkloads[0];
+    workload.Setup(cpu, *mem);
+    AsyncCPU async(cpu, *mem);
+
+    // when:
+    async.Run(workload.Cycles);
+    Event event = WaitForEnd(async);
+
+    // then:
+    EXPECT_EQ(event.Type, Event::HALTED);
+    AsyncCPU::ReadView view = async.Read();
+    EXPECT_TRUE(view->CPU.Halted);
+    EXPECT_EQ(view->Cycles, event.Cycles);
+    EXPECT_EQ(M6502::StateChecksum(view->CPU, view->Mem), workload.Checksum);
+}
+
+TEST_F(M6502AsyncTest, RunIsExecutedInFrames)
+{
+    // given:
+    LoadCountProgram();
+    AsyncCPU async(cpu, *mem, 1000);
+
+    // when:
+    async.Run(10000);
+    int frames = 0;
+    Event event = WaitForEnd(async, &frames);
+
+    // then:
+    EXPECT_EQ(event.Type, Event::STOPPED);
+    EXPECT_EQ(frames, 10);
+    EXPECT_GE(event.Cycles, 10000u);
+    AsyncCPU::ReadView view = async.Read();
+    EXPECT_EQ(view->Frame, 10u);
+    EXPECT_EQ(view->Mem[0x10], view->CPU.X);
+}
+
+TEST_F(M6502AsyncTest, BreakpointStopsTheRun)
+{
+    // given:
+    LoadCountProgram();
+    AsyncCPU async(cpu, *mem);
+    async.Break(0x0204);
+
+    // when:
+    async.Run(1000000);
+    Event event = WaitForEnd(async);
+
+    // then:
+    EXPECT_EQ(event.Type, Event::BREAKPOINT);
+    EXPECT_EQ(event.PC, 0x0204);
+    AsyncCPU::ReadView view = async.Read();
+    EXPECT_EQ(view->CPU.X, 1);
+    EXPECT_EQ(view->Mem[0x10], 0);
+}
+
+TEST_F(M6502AsyncTest, CommandsAreTakenInOrder)
+{
+    // given:
+    LoadCountProgram();
+    AsyncCPU async(cpu, *mem, 100);
+
+    // when:
+    async.Poke(0x20, 5);
+    async.Run(100);
+    for(int i = 0; i < 3; i++){
+        async.IRQ();
+        async.Run(100);
+    }
+    async.Snapshot();
+    WaitForEnd(async, nullptr, true);
+
+    // then:
+    AsyncCPU::ReadView view = async.Read();
+    EXPECT_EQ(view->Mem[0x20], 8);
+}
+
+TEST_F(M6502AsyncTest, PinnedViewDoesNotChange)
+{
+    // given:
+    LoadCountProgram();
+    AsyncCPU async(cpu, *mem, 1000);
+    async.Run(1000);
+    WaitForEnd(async);
+    AsyncCPU::ReadView view = async.Read();
+    M6502::u64 frame = view->Frame;
+    M6502::u8 counted = view->Mem[0x10];
+
+    // when:
+    async.Run(100000);
+    WaitForEnd(async);
+
+    // then:
+    EXPECT_EQ(view->Frame, frame);
+    EXPECT_EQ(view->Mem[0x10], counted);
+    EXPECT_GT(async.SkippedViews.load(), 0u);
+}
+
+TEST_F(M6502AsyncTest, SnapshotWaitsForTheHeldViewToBeReleased)
+{
+    // given:
+    LoadCountProgram();
+    AsyncCPU async(cpu, *mem);
+    std::unique_ptr<AsyncCPU::ReadView> held(new AsyncCPU::ReadView(async.Read()));
+    async.Snapshot();
+    WaitForEnd(async, nullptr, true);
+    async.Poke(0x30, 7);
+
+    // when:
+    async.Snapshot();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    Event event;
+    bool early = async.Poll(event);
+    held.reset();
+    WaitForEnd(async, nullptr, true);
+
+    // then:
+    EXPECT_FALSE(early);
+    EXPECT_GT(async.SkippedViews.load(), 0u);
+    AsyncCPU::ReadView view = async.Read();
+    EXPECT_EQ(view->Mem[0x30], 7);
+}
+
+TEST_F(M6502AsyncTest, QueuePassesItemsBetweenThreadsInOrder)
+{
+    // given:
+    std::unique_ptr<M6502::SPSCQueue<int, 64>> queue(new M6502::SPSCQueue<int, 64>);
+    const int count = 100000;
+
+    // when:
+    std::thread producer([&queue]{
+        for(int i = 0; i < count; i++){
+            while(!queue->Push(i)){
+                std::this_thread::yield();
+            }
+        }
+    });
+    int next = 0;
+    bool ordered = true;
+    while(next < count){
+        int value;
+        if(!queue->Pop(value)){
+            std::this_thread::yield();
+            continue;
+        }
+        ordered &= value == next++;
+    }
+    producer.join();
+
+    // then:
+    EXPECT_TRUE(ordered);
+    int value;
+    EXPECT_FALSE(queue->Pop(value));
+}
@@ -0,0 +1,410 @@
+#ifndef M6502_BATCH_H
+#define M6502_BATCH_H
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <list>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "cM6502.h"
+
+// Jobs of the headless batch runner, see batch.cpp for the manifest format.
+//
+// A job runs until a stop condition it asked for or until its cycles are
+// used up. Without brk or pc stops it runs in one Execute call, else one
+// instruction at a time so the stops are checked in between. Either way
+// the cycles reported are the ones the instructions used. A CPU that halts
+// without a halt stop ends the run with stop "cycles", one that waits idles
+// through the rest of the cycles.
+
+namespace M6502
+{
+    enum BatchStop : u8 { STOP_CYCLES, STOP_HALT, STOP_BRK, STOP_PC, STOP_WAIT, STOP_ERROR };
+    inline const char* const BatchStopNames[] = {"cycles", "halt", "brk", "pc", "wait", "error"};
+
+    struct BatchRange;
+    struct BatchInput;
+    struct BatchJob;
+    struct BatchResult;
+    struct BatchImages;
+}
+
+struct M6502::BatchRange{
+    u16 address;
+    u32 length;
+};
+
+struct M6502::BatchInput{
+    u16 address;
+    std::vector<u8> bytes;
+};
+
+struct M6502::BatchJob{
+    // the binary format counts ranges in a u16
+    static constexpr size_t MAX_DUMPS = 0xFFFF;
+
+    u32 id = 0;
+    std::shared_ptr<const std::vector<u8>> image;
+    u16 load = 0;
+    u16 pc = 0;
+    bool pcSet = false;
+    u8 a = 0, x = 0, y = 0, sp = 0xFF, p = 0x20;
+    std::vector<BatchInput> inputs;
+    long long cycles = 1000000;
+    bool stopHalt = true;
+    bool stopBrk = false;
+    bool stopPC = false;
+    u16 stopAddress = 0;
+    bool cmos = false;
+    std::vector<BatchRange> dumps;
+    std::string error;
+};
+
+struct M6502::BatchResult{
+    u32 id;
+    BatchStop stop;
+    u8 a, x, y, sp, p;
+    u16 pc;
+    long long cycles;
+    std::vector<BatchRange> dumps;
+    std::vector<u8> bytes;
+    std::string error;
+};
+
+// images by path, most manifests reuse a handful of them. Keeps the
+// Capacity used last.
+struct M6502::BatchImages{
+    using Image = std::shared_ptr<const std::vector<u8>>;
+
+    size_t Capacity = 64;
+
+    // nullptr when the file cannot be read
+    Image Load(const std::string& path)
+    {
+        auto found = index.find(path);
+        if(found != index.end()){
+            used.splice(used.begin(), used, found->second);
+            return found->second->second;
+        }
+        std::ifstream file(path, std::ios::binary);
+        if(!file){
+            return nullptr;
+        }
+        auto image = std::make_shared<std::vector<u8>>(
+            std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        used.emplace_front(path, image);
+        index[path] = used.begin();
+        while(used.size() > std::max<size_t>(Capacity, 1)){
+            index.erase(used.back().first);
+            used.pop_back();
+        }
+        return image;
+    }
+
+    size_t Size() const
+    {
+        return used.size();
+    }
+
+private:
+    // most recently used first
+    std::list<std::pair<std::string, Image>> used;
+    std::unordered_map<std::string, std::list<std::pair<std::string, Image>>::iterator> index;
+};
+
+namespace M6502
+{
+    // decimal, 0x hex or 0 octal between 0 and max, false for anything else
+    inline bool ParseBatchNumber(const std::string& text, long long max, long long& value)
+    {
+        if(text.empty() || text[0] == '-' || text[0] == '+' || isspace(static_cast<unsigned char>(text[0]))){
+            return false;
+        }
+        char* end;
+        errno = 0;
+        value = strtoll(text.c_str(), &end, 0);
+        return !*end && errno == 0 && value <= max;
+    }
+
+    inline bool ParseBatchHex(const std::string& text, std::vector<u8>& bytes)
+    {
+        if(text.size() % 2){
+            return false;
+        }
+        for(size_t i = 0; i < text.size(); i += 2){
+            if(!isxdigit(static_cast<unsigned char>(text[i])) || !isxdigit(static_cast<unsigned char>(text[i + 1]))){
+                return false;
+            }
+            char pair[3] = {text[i], text[i + 1], 0};
+            bytes.push_back(static_cast<u8>(strtol(pair, nullptr, 16)));
+        }
+        return true;
+    }
+
+    // fills in job from one manifest line, errors go into job.error
+    inline void ParseBatchJob(const std::string& line, BatchJob& job, BatchImages& images)
+    {
+        std::istringstream tokens(line);
+        std::string token;
+        while(tokens >> token){
+            size_t eq = token.find('=');
+            if(eq == std::string::npos){
+                job.error = "bad token " + token;
+                return;
+            }
+            std::string key = token.substr(0, eq);
+            std::string value = token.substr(eq + 1);
+            long long number = 0;
+            // the value as a number up to max, else an error for the token
+            auto parse = [&](const std::string& text, long long max){
+                if(!ParseBatchNumber(text, max, number)){
+                    job.error = "bad " + key + " " + value;
+                    return false;
+                }
+                return true;
+            };
+            u8* reg = key == "a" ? &job.a : key == "x" ? &job.x : key == "y" ? &job.y :
+                      key == "sp" ? &job.sp : key == "p" ? &job.p : nullptr;
+            if(key == "image"){
+                job.image = images.Load(value);
+                if(!job.image){
+                    job.error = "cannot read " + value;
+                    return;
+                }
+            }else if(key == "load"){
+                if(!parse(value, 0xFFFF)){
+                    return;
+                }
+                job.load = static_cast<u16>(number);
+            }else if(key == "pc"){
+                if(!parse(value, 0xFFFF)){
+                    return;
+                }
+                job.pc = static_cast<u16>(number);
+                job.pcSet = true;
+            }else if(reg){
+                if(!parse(value, 0xFF)){
+                    return;
+                }
+                *reg = static_cast<u8>(number);
+            }else if(key == "cycles"){
+                if(!parse(value, LLONG_MAX)){
+                    return;
+                }
+                job.cycles = number;
+            }else if(key == "variant"){
+                if(value != "6502" && value != "65c02"){
+                    job.error = "unknown variant " + value;
+                    return;
+                }
+                job.cmos = (value == "65c02");
+            }else if(key == "input" || key == "dump"){
+                size_t colon = value.find(':');
+                if(colon == std::string::npos){
+                    job.error = "bad " + key + " " + value;
+                    return;
+                }
+                if(!parse(value.substr(0, colon), 0xFFFF)){
+                    return;
+                }
+                u16 address = static_cast<u16>(number);
+                if(key == "dump"){
+                    if(!ParseBatchNumber(value.substr(colon + 1), Mem::MAX_MEM, number)){
+                        job.error = "bad dump length " + value;
+                        return;
+                    }
+                    if(job.dumps.size() == BatchJob::MAX_DUMPS){
+                        job.error = "too many dumps";
+                        return;
+                    }
+                    job.dumps.push_back({address, static_cast<u32>(number)});
+                    continue;
+                }
+                BatchInput input{address, {}};
+                if(!ParseBatchHex(value.substr(colon + 1), input.bytes)){
+                    job.error = "bad input " + value;
+                    return;
+                }
+                job.inputs.push_back(std::move(input));
+            }else if(key == "stop"){
+                job.stopHalt = false;
+                std::istringstream conditions(value);
+                std::string condition;
+                while(std::getline(conditions, condition, ',')){
+                    if(condition == "halt"){
+                        job.stopHalt = true;
+                    }else if(condition == "brk"){
+                        job.stopBrk = true;
+                    }else if(condition.compare(0, 3, "pc:") == 0 &&
+                             ParseBatchNumber(condition.substr(3), 0xFFFF, number)){
+                        job.stopPC = true;
+                        job.stopAddress = static_cast<u16>(number);
+                    }else if(condition != "cycles"){
+                        job.error = "bad stop " + condition;
+                        return;
+                    }
+                }
+            }else{
+                job.error = "unknown key " + key;
+                return;
+            }
+        }
+        if(!job.pcSet){
+            job.pc = job.load;
+        }
+    }
+
+    template<typename CPUType>
+    void RunBatchJob(const BatchJob& job, Mem& mem, BatchResult& result)
+    {
+        CPUType cpu;
+        cpu.Reset(mem);
+        if(job.image){
+            size_t length = std::min<size_t>(job.image->size(), Mem::MAX_MEM - job.load);
+            memcpy(mem.data + job.load, job.image->data(), length);
+        }
+        for(const BatchInput& input : job.inputs){
+            size_t length = std::min<size_t>(input.bytes.size(), Mem::MAX_MEM - input.address);
+            memcpy(mem.data + input.address, input.bytes.data(), length);
+        }
+        cpu.PC = job.pc;
+        cpu.A = job.a;
+        cpu.X = job.x;
+        cpu.Y = job.y;
+        cpu.SP = job.sp;
+        cpu.SetStatus(job.p);
+
+        BatchStop stop = STOP_CYCLES;
+        long long used = 0;
+        // halts and WAI end Execute by themselves
+        bool stepping = job.stopBrk || job.stopPC;
+        while(used < job.cycles){
+            if(job.stopPC && cpu.PC == job.stopAddress){
+                stop = STOP_PC;
+                break;
+            }
+            if(job.stopBrk && mem[cpu.PC] == CPUType::INS_BRK){
+                stop = STOP_BRK;
+                break;
+            }
+            // stop conditions are checked between instructions
+            int budget = stepping ? 1 : static_cast<int>(std::min<long long>(job.cycles - used, 0x7FFFFFFF));
+            used += cpu.Execute(budget, mem);
+            if(cpu.Halted){
+                stop = job.stopHalt ? STOP_HALT : STOP_CYCLES;
+                break;
+            }
+            if(cpu.Waiting){
+                if(job.stopHalt){
+                    stop = STOP_WAIT;
+                }else{
+                    used = std::max(used, job.cycles);
+                }
+                break;
+            }
+        }
+
+        result.stop = stop;
+        result.a = cpu.A;
+        result.x = cpu.X;
+        result.y = cpu.Y;
+        result.sp = cpu.SP;
+        result.p = cpu.GetStatus();
+        result.pc = cpu.PC;
+        result.cycles = used;
+        result.error.clear();
+        result.dumps = job.dumps;
+        result.bytes.clear();
+        for(const BatchRange& range : job.dumps){
+            for(u32 i = 0; i < range.length; i++){
+                result.bytes.push_back(mem[(range.address + i) & 0xFFFF]);
+            }
+        }
+    }
+
+    inline void RunBatchJob(const BatchJob& job, Mem& mem, BatchResult& result)
+    {
+        result.id = job.id;
+        if(!job.error.empty()){
+            result = BatchResult{job.id, STOP_ERROR, 0, 0, 0, 0, 0, 0, 0, {}, {}, job.error};
+            return;
+        }
+        if(job.cmos){
+            RunBatchJob<CPU65C02>(job, mem, result);
+        }else{
+            RunBatchJob<CPU>(job, mem, result);
+        }
+    }
+
+    inline void WriteBatchJSON(const BatchResult& result, std::string& out)
+    {
+        char buffer[256];
+        snprintf(buffer, sizeof(buffer),
+            "{\"job\":%u,\"stop\":\"%s\",\"a\":%u,\"x\":%u,\"y\":%u,\"sp\":%u,\"p\":%u,\"pc\":%u,\"cycles\":%lld",
+            result.id, BatchStopNames[result.stop], result.a, result.x, result.y, result.sp, result.p, result.pc,
+            result.cycles);
+        out += buffer;
+        if(!result.error.empty()){
+            out += ",\"error\":\"";
+            for(char c : result.error){
+                if(c == '"' || c == '\\'){
+                    out += '\\';
+                }
+                out += c;
+            }
+            out += "\"";
+        }
+        if(!result.dumps.empty()){
+            out += ",\"mem\":[";
+            static const char digits[] = "0123456789abcdef";
+            size_t offset = 0;
+            for(size_t i = 0; i < result.dumps.size(); i++){
+                snprintf(buffer, sizeof(buffer), "%s{\"addr\":%u,\"hex\":\"", i ? "," : "", result.dumps[i].address);
+                out += buffer;
+                for(u32 j = 0; j < result.dumps[i].length; j++){
+                    u8 value = result.bytes[offset++];
+                    out += digits[value >> 4];
+                    out += digits[value & 0x0F];
+                }
+                out += "\"}";
+            }
+            out += "]";
+        }
+        out += "}\n";
+    }
+
+    // little endian: u32 job, u8 stop, a, x, y, sp, p, u16 pc, u64 cycles,
+    // u16 range count, then per range u16 address, u32 length and the bytes
+    inline void WriteBatchBinary(const BatchResult& result, std::string& out)
+    {
+        auto put = [&out](unsigned long long value, int bytes){
+            for(int i = 0; i < bytes; i++){
+                out += static_cast<char>((value >> (8 * i)) & 0xFF);
+            }
+        };
+        put(result.id, 4);
+        put(result.stop, 1);
+        put(result.a, 1);
+        put(result.x, 1);
+        put(result.y, 1);
+        put(result.sp, 1);
+        put(result.p, 1);
+        put(result.pc, 2);
+        put(result.cycles, 8);
+        put(result.dumps.size(), 2);
+        size_t offset = 0;
+        for(const BatchRange& range : result.dumps){
+            put(range.address, 2);
+            put(range.length, 4);
+            out.append(reinterpret_cast<const char*>(result.bytes.data() + offset), range.length);
+            offset += range.length;
+        }
+    }
+}
+#endif
@@ -0,0 +1,289 @@
+#include <cstdio>
+#include <memory>
+#include <string>
+#include "gtest/gtest.h"
+#include "M6502Batch.h"
+
+class M6502BatchTest : public testing::Test
+{
+public:
+    std::unique_ptr<M6502::Mem> mem{new M6502::Mem};
+    M6502::BatchImages images;
+    M6502::BatchJob job;
+    M6502::BatchResult result;
+
+    void Run(const std::string& line)
+    {
+        job = M6502::BatchJob{};
+        M6502::ParseBatchJob(line, job, images);
+        M6502::RunBatchJob(job, *mem, result);
+    }
+
+    std::string WriteImage(const char* name, const std::string& bytes)
+    {
+        std::string path = testing::TempDir() + name;
+        FILE* file = fopen(path.c_str(), "wb");
+        fwrite(bytes.data(), 1, bytes.size(), file);
+        fclose(file);
+        return path;
+    }
+};
+
+TEST_F(M6502BatchTest, ManifestLineIsParsed)
+{
+    // given:
+    std::string line = "load=0x0300 a=1 x=2 y=3 sp=0xF0 p=0x24 input=0x0010:01ff cycles=500 "
+                       "stop=brk,pc:0x0310 dump=0x0010:2 variant=65c02";
+
+    // when:
+    M6502::ParseBatchJob(line, job, images);
+
+    // then:
+    EXPECT_TRUE(job.error.empty());
+    EXPECT_EQ(job.load, 0x0300);
+    EXPECT_EQ(job.pc, 0x0300);
+    EXPECT_EQ(job.a, 1);
+    EXPECT_EQ(job.x, 2);
+    EXPECT_EQ(job.y, 3);
+    EXPECT_EQ(job.sp, 0xF0);
+    EXPECT_EQ(job.p, 0x24);
+    ASSERT_EQ(job.inputs.size(), 1u);
+    EXPECT_EQ(job.inputs[0].address, 0x0010);
+    EXPECT_EQ(job.inputs[0].bytes, (std::vector<M6502::u8>{0x01, 0xFF}));
+    EXPECT_EQ(job.cycles, 500);
+    EXPECT_FALSE(job.stopHalt);
+    EXPECT_TRUE(job.stopBrk);
+    EXPECT_TRUE(job.stopPC);
+    EXPECT_EQ(job.stopAddress, 0x0310);
+    ASSERT_EQ(job.dumps.size(), 1u);
+    EXPECT_EQ(job.dumps[0].length, 2u);
+    EXPECT_TRUE(job.cmos);
+}
+
+TEST_F(M6502BatchTest, BadLinesAreErrors)
+{
+    const char* lines[] = {"foo=1", "pc", "input=0x0200:0", "stop=never", "dump=0x0000:0x10001", "dump=0:-1",
+                           "image=/nonexistent/image.bin", "input=0x0200:0g", "input=0x0200:-1"};
+    for(const char* line : lines){
+        // when:
+        Run(line);
+
+        // then:
+        EXPECT_EQ(result.stop, M6502::STOP_ERROR) << line;
+        EXPECT_FALSE(result.error.empty()) << line;
+    }
+}
+
+TEST_F(M6502BatchTest, NumbersThatAreNotNumbersOrDoNotFitAreErrors)
+{
+    const char* lines[] = {"load=zz", "load=0x10000", "pc=", "pc=12ab", "a=256", "x=-1", "sp=0x100",
+                           "p=+1", "cycles=1e6", "input=0x10000:00", "dump=zz:1", "dump=0:1x",
+                           "stop=pc:0x10000", "stop=pc:", "cycles=99999999999999999999"};
+    for(const char* line : lines){
+        // when:
+        Run(line);
+
+        // then:
+        EXPECT_EQ(result.stop, M6502::STOP_ERROR) << line;
+        EXPECT_FALSE(result.error.empty()) << line;
+    }
+}
+
+TEST_F(M6502BatchTest, NumbersAtTheirLimitsAreTaken)
+{
+    // when:
+    M6502::ParseBatchJob("load=0xFFFF a=255 sp=0377 stop=pc:65535 dump=0xFFFF:65536", job, images);
+
+    // then:
+    EXPECT_TRUE(job.error.empty()) << job.error;
+    EXPECT_EQ(job.load, 0xFFFF);
+    EXPECT_EQ(job.a, 0xFF);
+    EXPECT_EQ(job.sp, 0xFF);
+    EXPECT_EQ(job.stopAddress, 0xFFFF);
+    EXPECT_EQ(job.dumps[0].length, 0x10000u);
+}
+
+TEST_F(M6502BatchTest, UnknownVariantsAreErrors)
+{
+    // when:
+    Run("variant=65816");
+
+    // then:
+    EXPECT_EQ(result.stop, M6502::STOP_ERROR);
+    EXPECT_EQ(result.error, "unknown variant 65816");
+
+    // when:
+    Run("variant=6502");
+
+    // then:
+    EXPECT_NE(result.stop, M6502::STOP_ERROR);
+    EXPECT_FALSE(job.cmos);
+}
+
+TEST_F(M6502BatchTest, DumpsBeyondTheBinaryRangeCountAreErrors)
+{
+    // given:
+    std::string line;
+    for(size_t i = 0; i <= M6502::BatchJob::MAX_DUMPS; i++){
+        line += "dump=0:1 ";
+    }
+
+    // when:
+    Run(line);
+
+    // then:
+    EXPECT_EQ(result.stop, M6502::STOP_ERROR);
+    EXPECT_EQ(result.error, "too many dumps");
+}
+
+TEST_F(M6502BatchTest, HaltStopsWithTheCyclesUsed)
+{
+    // when: LDA #$01, JAM
+    Run("input=0x0200:a90102 pc=0x0200");
+
+    // then:
+    EXPECT_EQ(result.stop, M6502::STOP_HALT);
+    EXPECT_EQ(result.a, 1);
+    EXPECT_EQ(result.pc, 0x0202);
+    EXPECT_EQ(result.cycles, 3);
+}
+
+TEST_F(M6502BatchTest, SteppingCountsTheSameCycles)
+{
+    // given: LDX #$05, DEX, BNE -3, JAM
+    const std::string program = "input=0x0200:a205cad0fd02 pc=0x0200 ";
+
+    // when:
+    Run(program);
+    long long whole = result.cycles;
+    Run(program + "stop=halt,pc:0x1234");
+
+    // then:
+    EXPECT_EQ(result.stop, M6502::STOP_HALT);
+    EXPECT_EQ(result.cycles, whole);
+}
+
+TEST_F(M6502BatchTest, StopsOnBrkAndPC)
+{
+    // given: INX, INX, BRK
+    const std::string program = "input=0x0200:e8e800 pc=0x0200 ";
+
+    // when:
+    Run(program + "stop=brk");
+
+    // then:
+    EXPECT_EQ(result.stop, M6502::STOP_BRK);
+    EXPECT_EQ(result.pc, 0x0202);
+    EXPECT_EQ(result.x, 2);
+    EXPECT_EQ(result.cycles, 4);
+
+    // when:
+    Run(program + "stop=pc:0x0201");
+
+    // then:
+    EXPECT_EQ(result.stop, M6502::STOP_PC);
+    EXPECT_EQ(result.x, 1);
+}
+
+TEST_F(M6502BatchTest, RunsOutOfCycles)
+{
+    // when: JMP $0200
+    Run("input=0x0200:4c0002 pc=0x0200 cycles=100");
+
+    // then:
+    EXPECT_EQ(result.stop, M6502::STOP_CYCLES);
+    EXPECT_GE(result.cycles, 100);
+    EXPECT_LT(result.cycles, 103);
+}
+
+TEST_F(M6502BatchTest, WaitStopsOrIdles)
+{
+    // when: WAI
+    Run("input=0x0200:cb pc=0x0200 variant=65c02 cycles=100");
+
+    // then:
+    EXPECT_EQ(result.stop, M6502::STOP_WAIT);
+
+    // when:
+    Run("input=0x0200:cb pc=0x0200 variant=65c02 cycles=100 stop=cycles");
+
+    // then:
+    EXPECT_EQ(result.stop, M6502::STOP_CYCLES);
+    EXPECT_EQ(result.cycles, 100);
+}
+
+TEST_F(M6502BatchTest, ResultIsWrittenAsJSON)
+{
+    // given:
+    Run("input=0x0200:a9ab02 pc=0x0200 dump=0x0200:3");
+    result.id = 7;
+    std::string out;
+
+    // when:
+    M6502::WriteBatchJSON(result, out);
+
+    // then:
+    EXPECT_EQ(out, "{\"job\":7,\"stop\":\"halt\",\"a\":171,\"x\":0,\"y\":0,\"sp\":255,\"p\":160,\"pc\":514,"
+                   "\"cycles\":3,\"mem\":[{\"addr\":512,\"hex\":\"a9ab02\"}]}\n");
+}
+
+TEST_F(M6502BatchTest, ErrorsAreEscapedInJSON)
+{
+    // given:
+    Run("stop=\"x\\");
+    std::string out;
+
+    // when:
+    M6502::WriteBatchJSON(result, out);
+
+    // then:
+    EXPECT_NE(out.find("\"stop\":\"error\""), std::string::npos);
+    EXPECT_NE(out.find("\"error\":\"bad stop \\\"x\\\\\""), std::string::npos);
+}
+
+TEST_F(M6502BatchTest, ResultIsWrittenAsBinary)
+{
+    // given:
+    Run("input=0x0200:a9ab02 pc=0x0200 dump=0x0201:1");
+    result.id = 0x01020304;
+    std::string out;
+
+    // when:
+    M6502::WriteBatchBinary(result, out);
+
+    // then:
+    const unsigned char expected[] = {
+        0x04, 0x03, 0x02, 0x01,                             // job
+        M6502::STOP_HALT, 0xAB, 0x00, 0x00, 0xFF, 0xA0,     // stop, a, x, y, sp, p
+        0x02, 0x02,                                         // pc
+        0x03, 0, 0, 0, 0, 0, 0, 0,                          // cycles
+        0x01, 0x00,                                         // ranges
+        0x01, 0x02, 0x01, 0x00, 0x00, 0x00, 0xAB,           // address, length, bytes
+    };
+    EXPECT_EQ(out, std::string(reinterpret_cast<const char*>(expected), sizeof(expected)));
+}
+
+TEST_F(M6502BatchTest, ImagesUsedLeastRecentlyAreDropped)
+{
+    // given:
+    images.Capacity = 2;
+    std::string a = WriteImage("batch_a.bin", "a");
+    std::string b = WriteImage("batch_b.bin", "b");
+    std::string c = WriteImage("batch_c.bin", "c");
+    auto first = images.Load(a);
+    images.Load(b);
+
+    // when:
+    bool same = images.Load(a) == first;
+    images.Load(c);
+
+    // then: b went, a stayed
+    EXPECT_TRUE(same);
+    EXPECT_EQ(images.Size(), 2u);
+    EXPECT_EQ(images.Load(a), first);
+    EXPECT_EQ(images.Size(), 2u);
+    remove(b.c_str());
+    EXPECT_EQ(images.Load(b), nullptr);
+    remove(a.c_str());
+    remove(c.c_str());
+}
@@ -0,0 +1,86 @@
+#include <memory>
+#include <string>
+#include "gtest/gtest.h"
+#include "M6502Workloads.h"
+
+class M6502BenchmarkTest : public testing::Test
+{
+public:
+    std::unique_ptr<M6502::Mem> mem{new M6502::Mem};
+    M6502::CPU cpu;
+
+    void Run(const char* name)
+    {
+        for(const M6502::Workload& workload : M6502::BenchmarkWorkloads){
+            if(std::string(workload.Name) == name){
+                workload.Setup(cpu, *mem);
+                workload.Run(cpu, *mem);
+                ASSERT_TRUE(cpu.Halted);
+                return;
+            }
+        }
+        FAIL() << "no workload " << name;
+    }
+};
+
+TEST_F(M6502BenchmarkTest, EveryWorkloadEndsWithItsChecksum)
+{
+    for(const M6502::Workload& workload : M6502::BenchmarkWorkloads){
+        SCOPED_TRACE(workload.Name);
+        workload.Setup(cpu, *mem);
+        workload.Run(cpu, *mem);
+        EXPECT_TRUE(cpu.Halted);
+        EXPECT_EQ(M6502::StateChecksum(cpu, *mem), workload.Checksum);
+    }
+}
+
+TEST_F(M6502BenchmarkTest, SieveCountsThePrimesBelow8192)
+{
+    Run("sieve");
+    M6502::Mem& m = *mem;
+    EXPECT_EQ(m[0x14] | (m[0x15] << 8), 1028);
+}
+
+TEST_F(M6502BenchmarkTest, SortLeavesThePermutationInOrder)
+{
+    Run("sort");
+    for(int i = 0; i < 256; i++){
+        EXPECT_EQ((*mem)[0x1000 + i], i);
+    }
+}
+
+TEST_F(M6502BenchmarkTest, CRC32MatchesTheReferenceValue)
+{
+    Run("crc32");
+    M6502::Mem& m = *mem;
+    M6502::u32 crc = m[0x20] | (m[0x21] << 8) | (m[0x22] << 16) | (m[0x23] << 24);
+    EXPECT_EQ(crc, 0xB70B4C26u);
+}
+
+TEST_F(M6502BenchmarkTest, BCDCounterAndSumAreDecimal)
+{
+    Run("bcd");
+    M6502::Mem& m = *mem;
+    // 00010000 and 50005000, low byte first
+    EXPECT_EQ(m[0x30], 0x00);
+    EXPECT_EQ(m[0x31], 0x00);
+    EXPECT_EQ(m[0x32], 0x01);
+    EXPECT_EQ(m[0x33], 0x00);
+    EXPECT_EQ(m[0x34], 0x00);
+    EXPECT_EQ(m[0x35], 0x50);
+    EXPECT_EQ(m[0x36], 0x00);
+    EXPECT_EQ(m[0x37], 0x50);
+}
+
+TEST_F(M6502BenchmarkTest, InterpreterComputesTheHash)
+{
+    Run("interpreter");
+    EXPECT_EQ((*mem)[0x50], 0xF3);
+}
+
+TEST_F(M6502BenchmarkTest, TimerStopsAfter10240Ticks)
+{
+    Run("timer");
+    M6502::Mem& m = *mem;
+    EXPECT_EQ(m[0x62] | (m[0x63] << 8), 10240);
+}
@@ -0,0 +1,139 @@
+#ifndef M6502_COVERAGE_H
+#define M6502_COVERAGE_H
+#include <cstring>
+#include <string>
+#include "cM6502.h"
+#include "M6502Opcodes.h"
+
+// AFL style edge coverage of guest code.
+//
+// ExecuteCovered runs like Execute and after every control transfer
+// (branches taken or not, jumps, calls, returns, BRK) counts the edge from
+// the address of the instruction to the new PC in a 64KB map, at
+//
+//   Location(to) ^ Location(from) >> 1
+//
+// where Location scatters addresses over the map. Other instructions cost
+// one table lookup. Counts wrap like AFL's, NewBits buckets them (1, 2, 3,
+// 4-7, 8-15, 16-31, 32-127, 128+) so a loop running a different number of
+// times counts as new coverage too.
+
+namespace M6502
+{
+    using u64 = unsigned long long;
+    struct Coverage;
+}
+
+struct M6502::Coverage{
+    static constexpr u32 MAP_SIZE = 1 << 16;
+
+    u8 Map[MAP_SIZE];
+    // buckets seen so far over all runs
+    u8 Seen[MAP_SIZE];
+
+    Coverage()
+    {
+        memset(Map, 0, MAP_SIZE);
+        memset(Seen, 0, MAP_SIZE);
+    }
+
+    static u16 Location(u16 pc)
+    {
+        return (pc * 0x9E3779B1u) >> 16;
+    }
+
+    void Edge(u16 from, u16 to)
+    {
+        Map[static_cast<u16>(Location(to) ^ Location(from) >> 1)]++;
+    }
+
+    void Clear()
+    {
+        memset(Map, 0, MAP_SIZE);
+    }
+
+    static u8 Bucket(u8 count)
+    {
+        if(count < 4){
+            return count == 3 ? 4 : count;
+        }
+        return count < 8 ? 8 : count < 16 ? 16 : count < 32 ? 32 : count < 128 ? 64 : 128;
+    }
+
+    // adds the buckets of Map to Seen, true when one of them is new
+    bool NewBits()
+    {
+        bool found = false;
+        for(u32 word = 0; word < MAP_SIZE / 8; word++){
+            // most of the map is zero, skip it 8 bytes at a time
+            u64 bytes;
+            memcpy(&bytes, Map + word * 8, 8);
+            if(!bytes){
+                continue;
+            }
+            for(u32 i = word * 8; i < word * 8 + 8; i++){
+                u8 bucket = Bucket(Map[i]);
+                if(bucket & ~Seen[i]){
+                    Seen[i] |= bucket;
+                    found = true;
+                }
+            }
+        }
+        return found;
+    }
+
+    // edges in Map, or seen so far
+    u32 Edges(bool seen = false) const
+    {
+        const u8* map = seen ? Seen : Map;
+        u32 count = 0;
+        for(u32 i = 0; i < MAP_SIZE; i++){
+            count += map[i] != 0;
+        }
+        return count;
+    }
+
+    // opcodes that transfer control on CPUType
+    template<typename CPUType>
+    static const bool* Transfers()
+    {
+        struct Table{
+            bool Transfers[256] = {};
+
+            Table()
+            {
+                for(int opcode = 0; opcode < 256; opcode++){
+                    const OpcodeInfo& info = OpcodeInfo::Of<CPUType>(opcode);
+                    std::string mnemonic = info.Mnemonic;
+                    Transfers[opcode] = info.Operand == OpcodeInfo::REL || info.Operand == OpcodeInfo::ZPREL ||
+                        mnemonic == "JMP" || mnemonic == "JSR" || mnemonic == "RTS" || mnemonic == "RTI" ||
+                        mnemonic == "BRK";
+                }
+            }
+        };
+        static const Table table;
+        return table.Transfers;
+    }
+};
+
+namespace M6502
+{
+    template<typename CPUType>
+    int ExecuteCovered(CPUType& cpu, int cycles, typename CPUType::MemoryType& mem, Coverage& coverage)
+    {
+        const typename CPUType::OpTable& ops = OpcodeTable<CPUType>::Table;
+        const bool* transfers = Coverage::Transfers<CPUType>();
+        int requestedCycles = cycles;
+        while(cycles > 0){
+            u16 from = cpu.PC;
+            u8 ins = cpu.FetchByte(mem);
+            cycles -= ops.Cycles[ins];
+            ops.Handlers[ins](cpu, mem, cycles);
+            if(transfers[ins]){
+                coverage.Edge(from, cpu.PC);
+            }
+        }
+        return cpu.Used(requestedCycles, cycles);
+    }
+}
+#endif
@@ -0,0 +1,23 @@
+// Generated by fusiongen from memcpy memset checksum delay flags, do not edit.
+#ifndef M6502_DEFAULT_FUSION_H
+#define M6502_DEFAULT_FUSION_H
+#include "M6502Fusion.h"
+
+namespace M6502
+{
+    // share of all executed opcode pairs in the comments
+    using DefaultFusion = FusionSet<
+        Fuse<0xD0, 0xCA, 0x79, 0x9D, 0xB1>,  // 29.18%
+        Fuse<0xCA, 0xD0>,  // 12.38%
+        Fuse<0xC8, 0xD0>,  // 10.72%
+        Fuse<0x79, 0xC8>,  // 6.86%
+        Fuse<0x9D, 0xE8>,  // 6.19%
+        Fuse<0xE8, 0xD0>,  // 6.19%
+        Fuse<0x05, 0x05, 0x85>,  // 6.02%
+        Fuse<0xA5, 0x05, 0x4A>,  // 4.01%
+        Fuse<0x91, 0xC8>,  // 3.86%
+        Fuse<0xB1, 0x91>,  // 3.86%
+        Fuse<0x85, 0xE6>  // 2.01%
+    >;
+}
+#endif
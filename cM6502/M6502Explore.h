@@ -0,0 +1,624 @@
+#ifndef M6502_EXPLORE_H
+#define M6502_EXPLORE_H
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "cM6502.h"
+#include "M6502Fuzz.h"
+
+// Exhaustive state-space exploration of guest routines.
+//
+// The Explorer starts from the CPU and memory it was given, with every
+// possible input of InputSize bytes written at InputAddress, and runs all of
+// them breadth first in steps of StepCycles. A state is the CPU registers
+// plus the pages that differ from the starting memory. Pages are hash-consed
+// in a PageStore: equal pages are stored once and states refer to them by
+// id, so most states cost a few bytes beyond the pages they changed.
+//
+// After every step all new states are fingerprinted (a 64 bit hash of the
+// registers and page contents) and states seen before, over any path, are
+// dropped, their future has been explored already. This is also what ends
+// infinite loops. States that halted (JAM, STP) or wait (WAI) go into
+// Finals, check those to verify the routine.
+//
+// Workers expand the frontier in parallel, each with its own DirtyMem. The
+// fingerprints of visited states stay in memory up to Visited.MaxInMemory,
+// beyond that they are merged into one sorted run in a temporary file.
+// Inputs are explored in batches of BatchInputs so the frontier stays
+// small, the visited states carry over between batches. After a batch only
+// the pages of Finals are kept.
+//
+// Two different states sharing a fingerprint would wrongly be taken as the
+// same one, the chance of that is negligible below billions of states.
+
+namespace M6502
+{
+    using u64 = unsigned long long;
+    struct PageStore;
+    struct VisitedSet;
+    template<typename CPUType = FuzzCPU> struct Explorer;
+}
+
+// hash-consed 256 byte pages, safe to use from several threads
+struct M6502::PageStore{
+    static constexpr u32 PAGE_SIZE = 256;
+    static constexpr u32 SHARDS = 64;
+    static constexpr u32 CHUNK_PAGES = 1024;
+    static constexpr u32 MAX_CHUNKS = 1024;
+
+    PageStore() : shards(new Shard[SHARDS])
+    {
+    }
+
+    static u64 Hash(const u8* page)
+    {
+        u64 hash = 0xCBF29CE484222325ull;
+        for(u32 i = 0; i < PAGE_SIZE; i += 8){
+            u64 word;
+            memcpy(&word, page + i, 8);
+            hash = (hash ^ word) * 0x9E3779B97F4A7C15ull;
+            hash ^= hash >> 29;
+        }
+        return hash;
+    }
+
+    // the id of a page with these bytes, the same for equal pages
+    u32 Intern(const u8* page)
+    {
+        return Intern(page, Hash(page));
+    }
+
+    // with the Hash of the page
+    u32 Intern(const u8* page, u64 hash)
+    {
+        Shard& shard = shards[hash % SHARDS];
+        std::lock_guard<std::mutex> lock(shard.Lock);
+        // a collision between different pages moves on to the next hash
+        for(;; hash++){
+            auto found = shard.Ids.find(hash);
+            if(found == shard.Ids.end()){
+                u32 index = shard.Count++;
+                if(index % CHUNK_PAGES == 0){
+                    if(index / CHUNK_PAGES == MAX_CHUNKS){
+                        throw std::length_error("page store full");
+                    }
+                    shard.Chunks[index / CHUNK_PAGES].reset(new u8[CHUNK_PAGES * PAGE_SIZE]);
+                }
+                u32 id = index * SHARDS + static_cast<u32>(&shard - shards.get());
+                memcpy(Data(id), page, PAGE_SIZE);
+                shard.Ids.emplace(hash, id);
+                return id;
+            }
+            if(memcmp(Data(found->second), page, PAGE_SIZE) == 0){
+                return found->second;
+            }
+        }
+    }
+
+    // the page's bytes, for ids interned before the last synchronisation
+    // with the interning thread
+    const u8* Data(u32 id) const
+    {
+        const Shard& shard = shards[id % SHARDS];
+        u32 index = id / SHARDS;
+        return shard.Chunks[index / CHUNK_PAGES].get() + (index % CHUNK_PAGES) * PAGE_SIZE;
+    }
+
+    u8* Data(u32 id)
+    {
+        return const_cast<u8*>(static_cast<const PageStore&>(*this).Data(id));
+    }
+
+    u64 Pages() const
+    {
+        u64 pages = 0;
+        for(u32 i = 0; i < SHARDS; i++){
+            pages += shards[i].Count;
+        }
+        return pages;
+    }
+
+    // page data plus an estimate of the index
+    u64 Bytes() const
+    {
+        return Pages() * (PAGE_SIZE + sizeof(u64) + sizeof(u32) + 2 * sizeof(void*));
+    }
+
+private:
+    struct Shard{
+        std::mutex Lock;
+        std::unordered_map<u64, u32> Ids;
+        std::unique_ptr<u8[]> Chunks[MAX_CHUNKS];
+        u32 Count = 0;
+    };
+    std::unique_ptr<Shard[]> shards;
+};
+
+// fingerprints of the states seen so far, spilled to a temporary file
+// beyond MaxInMemory
+//
+// A Bloom filter over the spilled fingerprints keeps most new states off
+// the disk. The few it lets through are looked up with a binary search in
+// the file, or with one pass over it when there are many of them.
+struct M6502::VisitedSet{
+    size_t MaxInMemory = size_t(1) << 22;
+    u64 Spills = 0;
+    // fingerprints looked up in the file
+    u64 Lookups = 0;
+
+    VisitedSet() = default;
+    VisitedSet(const VisitedSet&) = delete;
+    VisitedSet& operator=(const VisitedSet&) = delete;
+
+    ~VisitedSet()
+    {
+        if(run){
+            fclose(run);
+        }
+    }
+
+    // removes the fingerprints seen before from sorted, unique fingerprints
+    // and notes the rest as seen
+    void Filter(std::vector<u64>& fingerprints)
+    {
+        size_t kept = 0;
+        for(u64 fingerprint : fingerprints){
+            if(!recent.count(fingerprint) && !(runSize && InRun(fingerprint))){
+                fingerprints[kept++] = fingerprint;
+            }
+        }
+        fingerprints.resize(kept);
+        if(!pending.empty()){
+            FilterRun(fingerprints);
+        }
+        recent.insert(fingerprints.begin(), fingerprints.end());
+        if(recent.size() > MaxInMemory){
+            Spill();
+        }
+    }
+
+    u64 Size() const
+    {
+        return recent.size() + runSize;
+    }
+
+    // an estimate of the memory the set takes, not counting the file
+    u64 Bytes() const
+    {
+        return recent.size() * (sizeof(u64) + 2 * sizeof(void*)) + recent.bucket_count() * sizeof(void*) +
+               bloom.size() * sizeof(u64);
+    }
+
+    u64 SpilledBytes() const
+    {
+        return runSize * sizeof(u64);
+    }
+
+private:
+    static constexpr size_t BLOCK = 1 << 16;
+    static constexpr int BLOOM_BITS = 16;
+    static constexpr int BLOOM_HASHES = 3;
+
+    std::unordered_set<u64> recent;
+    FILE* run = nullptr;
+    u64 runSize = 0;
+    std::vector<u64> bloom;
+    // fingerprints that passed the filter, to look up in the file
+    std::vector<u64> pending;
+
+    u64 BloomBit(u64 fingerprint, int hash) const
+    {
+        u64 bits = bloom.size() * 64;
+        return (fingerprint >> (21 * hash) | fingerprint << (64 - 21 * hash) % 64) & (bits - 1);
+    }
+
+    // false when the run surely does not hold fingerprint, else notes it
+    // for FilterRun
+    bool InRun(u64 fingerprint)
+    {
+        for(int i = 0; i < BLOOM_HASHES; i++){
+            u64 bit = BloomBit(fingerprint, i);
+            if(!(bloom[bit / 64] >> (bit % 64) & 1)){
+                return false;
+            }
+        }
+        pending.push_back(fingerprint);
+        return false;
+    }
+
+    u64 Read(u64 index)
+    {
+        u64 fingerprint = 0;
+        fseek(run, static_cast<long>(index * sizeof(u64)), SEEK_SET);
+        if(fread(&fingerprint, sizeof(u64), 1, run) != 1){
+            throw std::runtime_error("cannot read visited states");
+        }
+        return fingerprint;
+    }
+
+    // drops the pending fingerprints found in the run from fingerprints
+    void FilterRun(std::vector<u64>& fingerprints)
+    {
+        Lookups += pending.size();
+        std::vector<u64> found;
+        u64 blocks = (runSize + BLOCK - 1) / BLOCK;
+        // a seek and a small read cost about an eighth of a block read
+        if(pending.size() * 64 < blocks * 8){
+            for(u64 fingerprint : pending){
+                u64 low = 0, high = runSize;
+                while(low < high){
+                    u64 middle = low + (high - low) / 2;
+                    if(Read(middle) < fingerprint){
+                        low = middle + 1;
+                    }else{
+                        high = middle;
+                    }
+                }
+                if(low < runSize && Read(low) == fingerprint){
+                    found.push_back(fingerprint);
+                }
+            }
+        }else{
+            rewind(run);
+            std::vector<u64> block(BLOCK);
+            size_t at = 0, filled = 0;
+            u64 left = runSize;
+            for(u64 fingerprint : pending){
+                for(;;){
+                    if(at == filled){
+                        filled = left ? fread(block.data(), sizeof(u64), std::min<u64>(BLOCK, left), run) : 0;
+                        left -= filled;
+                        at = 0;
+                        if(!filled){
+                            break;
+                        }
+                    }
+                    if(block[at] >= fingerprint){
+                        if(block[at] == fingerprint){
+                            found.push_back(fingerprint);
+                        }
+                        break;
+                    }
+                    at++;
+                }
+            }
+        }
+        pending.clear();
+        if(found.empty()){
+            return;
+        }
+        size_t kept = 0;
+        for(size_t i = 0, j = 0; i < fingerprints.size(); i++){
+            while(j < found.size() && found[j] < fingerprints[i]){
+                j++;
+            }
+            if(j == found.size() || found[j] != fingerprints[i]){
+                fingerprints[kept++] = fingerprints[i];
+            }
+        }
+        fingerprints.resize(kept);
+    }
+
+    // merges the fingerprints in memory into a new run
+    void Spill()
+    {
+        std::vector<u64> sorted(recent.begin(), recent.end());
+        std::sort(sorted.begin(), sorted.end());
+        recent = std::unordered_set<u64>();
+
+        FILE* merged = tmpfile();
+        if(!merged){
+            throw std::runtime_error("cannot create a temporary file for visited states");
+        }
+        u64 size = runSize + sorted.size();
+        u64 words = 1;
+        while(words * 64 < size * BLOOM_BITS){
+            words *= 2;
+        }
+        bloom.assign(words, 0);
+        std::vector<u64> block(BLOCK), out;
+        out.reserve(BLOCK);
+        auto put = [&](u64 fingerprint){
+            for(int i = 0; i < BLOOM_HASHES; i++){
+                u64 bit = BloomBit(fingerprint, i);
+                bloom[bit / 64] |= u64(1) << (bit % 64);
+            }
+            out.push_back(fingerprint);
+            if(out.size() == BLOCK){
+                fwrite(out.data(), sizeof(u64), out.size(), merged);
+                out.clear();
+            }
+        };
+        if(run){
+            rewind(run);
+        }
+        size_t next = 0;
+        for(u64 left = runSize; left;){
+            size_t filled = fread(block.data(), sizeof(u64), std::min<u64>(BLOCK, left), run);
+            if(!filled){
+                break;
+            }
+            left -= filled;
+            for(size_t i = 0; i < filled; i++){
+                while(next < sorted.size() && sorted[next] < block[i]){
+                    put(sorted[next++]);
+                }
+                put(block[i]);
+            }
+        }
+        while(next < sorted.size()){
+            put(sorted[next++]);
+        }
+        fwrite(out.data(), sizeof(u64), out.size(), merged);
+        fflush(merged);
+        if(ferror(merged)){
+            fclose(merged);
+            throw std::runtime_error("cannot write visited states");
+        }
+        if(run){
+            fclose(run);
+        }
+        run = merged;
+        runSize = size;
+        Spills++;
+    }
+};
+
+template<typename CPUType>
+struct M6502::Explorer{
+    struct PageRef{
+        u8 Page;
+        u32 Id;
+    };
+
+    struct State{
+        u64 Fingerprint;
+        CPUType CPU;
+        // sorted by page
+        std::vector<PageRef> Pages;
+    };
+
+    const u16 InputAddress;
+    const u16 InputSize;
+    int StepCycles = 100;
+    // steps per batch, states still running after them are Unfinished
+    int MaxSteps = 100000;
+    u64 BatchInputs = 1 << 16;
+    int Threads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::unique_ptr<PageStore> Pages{new PageStore};
+    VisitedSet Visited;
+    // distinct states that halted or wait
+    std::vector<State> Finals;
+
+    u64 Inputs = 0;
+    // distinct states explored
+    u64 States = 0;
+    // states dropped as seen before
+    u64 Duplicates = 0;
+    u64 Unfinished = 0;
+    u64 Steps = 0;
+    double Seconds = 0;
+    // pages, visited fingerprints in memory, finals and frontier
+    u64 PeakBytes = 0;
+
+    Explorer(const CPUType& cpu, const DirtyMem& mem, u16 inputAddress, u16 inputSize)
+        : InputAddress(inputAddress), InputSize(inputSize), start(cpu), base(new DirtyMem(mem))
+    {
+        base->dirtyCount = 0;
+        memset(base->dirty, 0, sizeof(base->dirty));
+    }
+
+    // all inputs, from 0 to 256^InputSize - 1
+    void Explore()
+    {
+        Explore(0, InputSize >= 8 ? ~0ull : (1ull << (8 * InputSize)));
+    }
+
+    // inputs first to first + count - 1, bytes little endian
+    void Explore(u64 first, u64 count)
+    {
+        auto begin = std::chrono::steady_clock::now();
+        for(u64 done = 0; done < count;){
+            u64 batch = std::min(BatchInputs, count - done);
+            ExploreBatch(first + done, batch);
+            Compact();
+            done += batch;
+            Inputs += batch;
+        }
+        Seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    }
+
+    // puts state into cpu and mem
+    void Load(const State& state, CPUType& cpu, DirtyMem& mem) const
+    {
+        memcpy(mem.data, base->data, DirtyMem::MAX_MEM);
+        for(const PageRef& ref : state.Pages){
+            memcpy(mem.data + ref.Page * PageStore::PAGE_SIZE, Pages->Data(ref.Id), PageStore::PAGE_SIZE);
+        }
+        cpu = state.CPU;
+    }
+
+    double StatesPerSecond() const
+    {
+        return Seconds > 0 ? States / Seconds : 0;
+    }
+
+    // peak memory per distinct state
+    double BytesPerState() const
+    {
+        return States ? double(PeakBytes) / States : 0;
+    }
+
+private:
+    CPUType start;
+    std::unique_ptr<DirtyMem> base;
+    u64 finalBytes = 0;
+
+    static u64 Mix(u64 hash, u64 value)
+    {
+        hash = (hash ^ value) * 0x9E3779B97F4A7C15ull;
+        return hash ^ hash >> 32;
+    }
+
+    static u64 Bytes(const State& state)
+    {
+        return sizeof(State) + state.Pages.size() * sizeof(PageRef);
+    }
+
+    // fills in the pages mem changed from base, then restores it. The
+    // fingerprint hashes page contents, not ids, so it stays the same when
+    // Compact renumbers the pages.
+    void Capture(State& state, DirtyMem& mem)
+    {
+        const CPUType& cpu = state.CPU;
+        u64 registers = u64(cpu.PC) | u64(cpu.SP) << 16 | u64(cpu.A) << 24 | u64(cpu.X) << 32 |
+                        u64(cpu.Y) << 40 | u64(cpu.GetStatus()) << 48 | u64(cpu.Halted) << 56 |
+                        u64(cpu.Waiting) << 57;
+        u64 fingerprint = Mix(0, registers);
+        std::sort(mem.dirtyPages, mem.dirtyPages + mem.dirtyCount);
+        state.Pages.clear();
+        for(u32 i = 0; i < mem.dirtyCount; i++){
+            u32 page = mem.dirtyPages[i];
+            const u8* data = mem.data + page * PageStore::PAGE_SIZE;
+            if(memcmp(data, base->data + page * PageStore::PAGE_SIZE, PageStore::PAGE_SIZE) != 0){
+                u64 hash = PageStore::Hash(data);
+                state.Pages.push_back({static_cast<u8>(page), Pages->Intern(data, hash)});
+                fingerprint = Mix(fingerprint, page ^ hash);
+            }
+        }
+        state.Fingerprint = fingerprint;
+        mem.Restore(*base);
+    }
+
+    // runs from, leaves the result in to
+    void Step(const State& from, State& to, CPUType& cpu, DirtyMem& mem)
+    {
+        for(const PageRef& ref : from.Pages){
+            memcpy(mem.data + ref.Page * PageStore::PAGE_SIZE, Pages->Data(ref.Id), PageStore::PAGE_SIZE);
+            mem.dirty[ref.Page] = true;
+            mem.dirtyPages[mem.dirtyCount++] = ref.Page;
+        }
+        cpu = from.CPU;
+        cpu.Execute(StepCycles, mem);
+        to.CPU = cpu;
+        Capture(to, mem);
+    }
+
+    // runs work(thread, index) for every index below count on Threads threads
+    template<typename Work>
+    void Parallel(size_t count, Work work)
+    {
+        std::atomic<size_t> next{0};
+        auto run = [&](int thread){
+            for(size_t i; (i = next++) < count;){
+                work(thread, i);
+            }
+        };
+        std::vector<std::thread> workers;
+        for(int i = 1; i < Threads; i++){
+            workers.emplace_back(run, i);
+        }
+        run(0);
+        for(std::thread& worker : workers){
+            worker.join();
+        }
+    }
+
+    // keeps the states not seen before, in fingerprint order
+    void Deduplicate(std::vector<State>& states)
+    {
+        size_t before = states.size();
+        std::sort(states.begin(), states.end(),
+            [](const State& a, const State& b){ return a.Fingerprint < b.Fingerprint; });
+        states.erase(std::unique(states.begin(), states.end(),
+            [](const State& a, const State& b){ return a.Fingerprint == b.Fingerprint; }), states.end());
+        std::vector<u64> fingerprints(states.size());
+        for(size_t i = 0; i < states.size(); i++){
+            fingerprints[i] = states[i].Fingerprint;
+        }
+        Visited.Filter(fingerprints);
+        size_t kept = 0;
+        for(size_t i = 0, j = 0; i < states.size() && j < fingerprints.size(); i++){
+            if(states[i].Fingerprint == fingerprints[j]){
+                std::swap(states[kept++], states[i]);
+                j++;
+            }
+        }
+        states.resize(kept);
+        Duplicates += before - kept;
+        States += kept;
+    }
+
+    // moves the pages the finals use into a new store, the rest are garbage
+    // once a batch is done
+    void Compact()
+    {
+        std::unique_ptr<PageStore> pages(new PageStore);
+        for(State& state : Finals){
+            for(PageRef& ref : state.Pages){
+                ref.Id = pages->Intern(Pages->Data(ref.Id));
+            }
+        }
+        Pages = std::move(pages);
+    }
+
+    void ExploreBatch(u64 first, u64 count)
+    {
+        std::vector<std::unique_ptr<DirtyMem>> mems;
+        for(int i = 0; i < std::max(Threads, 1); i++){
+            mems.emplace_back(new DirtyMem(*base));
+        }
+        std::vector<CPUType> cpus(mems.size());
+
+        std::vector<State> frontier(count);
+        Parallel(count, [&](int thread, size_t i){
+            DirtyMem& mem = *mems[thread];
+            u64 input = first + i;
+            for(u32 byte = 0; byte < InputSize; byte++){
+                mem[static_cast<u16>(InputAddress + byte)] = byte < 8 ? input >> (8 * byte) : 0;
+            }
+            frontier[i].CPU = start;
+            Capture(frontier[i], mem);
+        });
+        Deduplicate(frontier);
+
+        std::vector<State> next;
+        for(int step = 0; !frontier.empty(); step++){
+            size_t running = 0;
+            u64 bytes = 0;
+            for(State& state : frontier){
+                if(state.CPU.Halted || state.CPU.Waiting){
+                    finalBytes += Bytes(state);
+                    Finals.push_back(std::move(state));
+                }else{
+                    bytes += Bytes(state);
+                    std::swap(frontier[running++], state);
+                }
+            }
+            frontier.resize(running);
+            PeakBytes = std::max(PeakBytes, Pages->Bytes() + Visited.Bytes() + finalBytes + bytes);
+            if(step == MaxSteps){
+                Unfinished += frontier.size();
+                break;
+            }
+            next.resize(frontier.size());
+            Parallel(frontier.size(), [&](int thread, size_t i){
+                Step(frontier[i], next[i], cpus[thread], *mems[thread]);
+            });
+            Steps++;
+            Deduplicate(next);
+            std::swap(frontier, next);
+        }
+    }
+};
+#endif
@@ -0,0 +1,156 @@
+#include <memory>
+#include "gtest/gtest.h"
+#include "M6502Explore.h"
+
+namespace
+{
+    // 16 bit product of $80 and $81 to $82/$83, the inputs stay
+    constexpr M6502::u8 MultiplyProgram[] = {
+        0xA5, 0x80,         // 0200 LDA $80
+        0x85, 0x84,         // 0202 STA $84
+        0xA9, 0x00,         // 0204 LDA #$00
+        0x85, 0x85,         // 0206 STA $85
+        0x85, 0x82,         // 0208 STA $82
+        0x85, 0x83,         // 020A STA $83
+        0xA5, 0x81,         // 020C LDA $81
+        0x85, 0x86,         // 020E STA $86
+        // loop
+        0x46, 0x86,         // 0210 LSR $86
+        0x90, 0x0D,         // 0212 BCC $0221
+        0x18,               // 0214 CLC
+        0xA5, 0x82,         // 0215 LDA $82
+        0x65, 0x84,         // 0217 ADC $84
+        0x85, 0x82,         // 0219 STA $82
+        0xA5, 0x83,         // 021B LDA $83
+        0x65, 0x85,         // 021D ADC $85
+        0x85, 0x83,         // 021F STA $83
+        // skip
+        0x06, 0x84,         // 0221 ASL $84
+        0x26, 0x85,         // 0223 ROL $85
+        0xA5, 0x86,         // 0225 LDA $86
+        0xD0, 0xE7,         // 0227 BNE $0210
+        0x02,               // 0229 JAM
+    };
+
+    // bits set in $80 to $81, shifts $80 out
+    constexpr M6502::u8 PopCountProgram[] = {
+        0xA9, 0x00,         // 0200 LDA #$00
+        0x85, 0x81,         // 0202 STA $81
+        0xA2, 0x08,         // 0204 LDX #$08
+        // loop
+        0x46, 0x80,         // 0206 LSR $80
+        0x90, 0x02,         // 0208 BCC $020C
+        0xE6, 0x81,         // 020A INC $81
+        // skip
+        0xCA,               // 020C DEX
+        0xD0, 0xF7,         // 020D BNE $0206
+        0x02,               // 020F JAM
+    };
+
+    // spins until $80 is zero, it never is
+    constexpr M6502::u8 SpinProgram[] = {
+        0xA5, 0x80,         // 0200 LDA $80
+        0xD0, 0xFC,         // 0202 BNE $0200
+        0x02,               // 0204 JAM
+    };
+}
+
+class M6502ExploreTest : public testing::Test
+{
+public:
+    std::unique_ptr<M6502::DirtyMem> mem{new M6502::DirtyMem};
+    M6502::FuzzCPU cpu;
+
+    template<M6502::u32 N>
+    void Load(const M6502::u8 (&program)[N])
+    {
+        cpu.Reset(*mem);
+        for(M6502::u32 i = 0; i < N; i++){
+            (*mem)[0x0200 + i] = program[i];
+        }
+        cpu.PC = 0x0200;
+    }
+};
+
+TEST_F(M6502ExploreTest, MultiplyIsRightForAllInputs)
+{
+    // given:
+    Load(MultiplyProgram);
+    M6502::Explorer<> explorer(cpu, *mem, 0x0080, 2);
+    explorer.Threads = 2;
+
+    // when:
+    explorer.Explore();
+
+    // then:
+    EXPECT_EQ(explorer.Inputs, 65536u);
+    EXPECT_EQ(explorer.Finals.size(), 65536u);
+    EXPECT_EQ(explorer.Unfinished, 0u);
+    std::unique_ptr<M6502::DirtyMem> final(new M6502::DirtyMem);
+    M6502::FuzzCPU finalCPU;
+    int wrong = 0;
+    for(const auto& state : explorer.Finals){
+        explorer.Load(state, finalCPU, *final);
+        wrong += ((*final)[0x82] | (*final)[0x83] << 8) != (*final)[0x80] * (*final)[0x81];
+    }
+    EXPECT_EQ(wrong, 0);
+}
+
+TEST_F(M6502ExploreTest, PathsThatMeetAreExploredOnce)
+{
+    // given:
+    Load(PopCountProgram);
+    M6502::Explorer<> explorer(cpu, *mem, 0x0080, 1);
+    explorer.StepCycles = 8;
+
+    // when:
+    explorer.Explore();
+
+    // then: counts 1 to 7 with the top bit set or clear, 0 and 8 once
+    EXPECT_EQ(explorer.Finals.size(), 16u);
+    EXPECT_GT(explorer.Duplicates, 0u);
+    std::unique_ptr<M6502::DirtyMem> final(new M6502::DirtyMem);
+    M6502::FuzzCPU finalCPU;
+    for(const auto& state : explorer.Finals){
+        explorer.Load(state, finalCPU, *final);
+        EXPECT_EQ((*final)[0x80], 0);
+        EXPECT_LE((*final)[0x81], 8);
+    }
+}
+
+TEST_F(M6502ExploreTest, LoopsEndWhenTheirStateRepeats)
+{
+    // given:
+    Load(SpinProgram);
+    M6502::Explorer<> explorer(cpu, *mem, 0x0080, 1);
+    explorer.StepCycles = 5;
+
+    // when:
+    explorer.Explore(1, 255);
+
+    // then:
+    EXPECT_EQ(explorer.Finals.size(), 0u);
+    EXPECT_EQ(explorer.Unfinished, 0u);
+    EXPECT_LT(explorer.Steps, 10u);
+}
+
+TEST_F(M6502ExploreTest, SpilledStatesAreStillSeen)
+{
+    // given:
+    Load(MultiplyProgram);
+    M6502::Explorer<> explorer(cpu, *mem, 0x0080, 2);
+    explorer.Visited.MaxInMemory = 10000;
+    explorer.BatchInputs = 4096;
+
+    // when: the second round only finds states seen before
+    explorer.Explore(0, 16384);
+    M6502::u64 states = explorer.States;
+    explorer.Explore(0, 8192);
+
+    // then:
+    EXPECT_GT(explorer.Visited.Spills, 0u);
+    EXPECT_GT(explorer.Visited.SpilledBytes(), 0u);
+    EXPECT_EQ(explorer.Finals.size(), 16384u);
+    EXPECT_EQ(explorer.States, states);
+    EXPECT_EQ(explorer.Visited.Size(), states);
+}
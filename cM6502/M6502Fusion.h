@@ -0,0 +1,138 @@
+#ifndef M6502_FUSION_H
+#define M6502_FUSION_H
+#include <unordered_map>
+#include "cM6502.h"
+
+// Opcode n-gram profiling and superinstructions.
+//
+// A Fuse<First, Seconds...> rule replaces the handler of First with one that
+// runs First and then, when one of Seconds is the next opcode, runs it
+// straight away with a direct call instead of going back through the table.
+// The second instruction is only started while cycles are left, exactly
+// like Execute would, so cycles, registers and flags stay identical.
+
+namespace M6502
+{
+    using u64 = unsigned long long;
+    struct OpcodeProfile;
+    template<u8 First, u8... Seconds> struct Fuse{};
+    template<typename... Rules> struct FusionSet{};
+    template<typename CPUType, typename Set> struct FusedOpcodeTable;
+}
+
+// 1, 2 and 3-gram counts of executed opcodes
+struct M6502::OpcodeProfile{
+    u64 Counts[256] = {};
+    u64 Pairs[256 * 256] = {};
+    std::unordered_map<u32, u64> Triples;
+    int Previous = -1;
+    int BeforePrevious = -1;
+
+    void Record(u8 ins)
+    {
+        Counts[ins]++;
+        if(Previous >= 0){
+            Pairs[(Previous << 8) | ins]++;
+            if(BeforePrevious >= 0){
+                Triples[(BeforePrevious << 16) | (Previous << 8) | ins]++;
+            }
+        }
+        BeforePrevious = Previous;
+        Previous = ins;
+    }
+
+    // sequences do not continue across separate runs
+    void Break()
+    {
+        Previous = BeforePrevious = -1;
+    }
+
+    u64 Total() const
+    {
+        u64 total = 0;
+        for(u64 count : Counts){
+            total += count;
+        }
+        return total;
+    }
+};
+
+namespace M6502
+{
+    template<typename CPUType>
+    int ExecuteProfiled(CPUType& cpu, int cycles, typename CPUType::MemoryType& mem, OpcodeProfile& profile)
+    {
+        const typename CPUType::OpTable& ops = OpcodeTable<CPUType>::Table;
+        int requestedCycles = cycles;
+        while(cycles > 0){
+            u8 ins = cpu.FetchByte(mem);
+            profile.Record(ins);
+            cycles -= ops.Cycles[ins];
+            ops.Handlers[ins](cpu, mem, cycles);
+        }
+        return cpu.Used(requestedCycles, cycles);
+    }
+
+    template<typename CPUType, u8 First, u8... Seconds>
+    struct FusedHandler{
+        using MemType = typename CPUType::MemoryType;
+        static constexpr const typename CPUType::OpTable& Base = OpcodeTable<CPUType>::Table;
+
+        template<u8 Second>
+        static bool RunSecond(CPUType& cpu, MemType& mem, int& cycles, u8 next)
+        {
+            if(next != Second){
+                return false;
+            }
+            cpu.PC++;
+            cycles -= Base.Cycles[Second];
+            Base.Handlers[Second](cpu, mem, cycles);
+            return true;
+        }
+
+        static void Run(CPUType& cpu, MemType& mem, int& cycles)
+        {
+            Base.Handlers[First](cpu, mem, cycles);
+            if(cycles <= 0){
+                return;
+            }
+            u8 next = cpu.ReadByte(cpu.PC, mem);
+            (RunSecond<Seconds>(cpu, mem, cycles, next) || ...);
+        }
+
+        static constexpr void Install(typename CPUType::OpTable& table)
+        {
+            table.Handlers[First] = &Run;
+        }
+    };
+
+    template<typename CPUType, typename... Rules>
+    struct FusedOpcodeTable<CPUType, FusionSet<Rules...>>{
+        template<typename Rule>
+        struct Installer;
+
+        template<u8 First, u8... Seconds>
+        struct Installer<Fuse<First, Seconds...>>{
+            static constexpr void Install(typename CPUType::OpTable& table)
+            {
+                FusedHandler<CPUType, First, Seconds...>::Install(table);
+            }
+        };
+
+        static constexpr typename CPUType::OpTable Build()
+        {
+            typename CPUType::OpTable table = OpcodeTable<CPUType>::Table;
+            (Installer<Rules>::Install(table), ...);
+            return table;
+        }
+
+        static constexpr typename CPUType::OpTable Table = Build();
+    };
+
+    template<typename Set, typename CPUType>
+    int ExecuteFused(CPUType& cpu, int cycles, typename CPUType::MemoryType& mem)
+    {
+        return cpu.Execute(FusedOpcodeTable<CPUType, Set>::Table, cycles, mem);
+    }
+}
+#endif
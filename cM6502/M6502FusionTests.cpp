@@ -0,0 +1,97 @@
+#include <cstring>
+#include <memory>
+#include "gtest/gtest.h"
+#include "M6502DefaultFusion.h"
+#include "M6502Workloads.h"
+
+class M6502FusionTest : public testing::Test
+{
+public:
+    M6502::Mem plainMem;
+    M6502::Mem fusedMem;
+    M6502::CPU plain;
+    M6502::CPU fused;
+
+    void ExpectSameState()
+    {
+        EXPECT_EQ(plain.PC, fused.PC);
+        EXPECT_EQ(plain.SP, fused.SP);
+        EXPECT_EQ(plain.A, fused.A);
+        EXPECT_EQ(plain.X, fused.X);
+        EXPECT_EQ(plain.Y, fused.Y);
+        EXPECT_EQ(plain.GetStatus(), fused.GetStatus());
+        EXPECT_EQ(memcmp(plainMem.data, fusedMem.data, M6502::Mem::MAX_MEM), 0);
+    }
+};
+
+TEST_F(M6502FusionTest, FusedExecutionMatchesPlainExecutionForEverySliceSize)
+{
+    for(const M6502::Workload& workload : M6502::CorpusWorkloads){
+        for(int slice = 1; slice <= 13; slice++){
+            SCOPED_TRACE(workload.Name);
+            workload.Setup(plain, plainMem);
+            workload.Setup(fused, fusedMem);
+            for(int i = 0; i < 2000; i++){
+                int plainCycles = plain.Execute(slice, plainMem);
+                int fusedCycles = M6502::ExecuteFused<M6502::DefaultFusion>(fused, slice, fusedMem);
+                ASSERT_EQ(plainCycles, fusedCycles);
+            }
+            ExpectSameState();
+        }
+    }
+}
+
+TEST_F(M6502FusionTest, FusedPairRunsBothInstructionsInOneDispatch)
+{
+    using Pair = M6502::FusionSet<M6502::Fuse<M6502::CPU::INS_LDA_IM, M6502::CPU::INS_STA_ZP>>;
+    // given:
+    fused.Reset(fusedMem);
+    fusedMem[0xFFFC] = M6502::CPU::INS_LDA_IM;
+    fusedMem[0xFFFD] = 0x84;
+    fusedMem[0xFFFE] = M6502::CPU::INS_STA_ZP;
+    fusedMem[0xFFFF] = 0x42;
+
+    //when:
+    int cyclesUsed = M6502::ExecuteFused<Pair>(fused, 3, fusedMem);
+
+    // then:
+    EXPECT_EQ(cyclesUsed, 5);
+    EXPECT_EQ(fusedMem[0x0042], 0x84);
+}
+
+TEST_F(M6502FusionTest, FusedPairStopsWhenTheFirstInstructionUsesTheBudget)
+{
+    using Pair = M6502::FusionSet<M6502::Fuse<M6502::CPU::INS_LDA_IM, M6502::CPU::INS_STA_ZP>>;
+    // given:
+    fused.Reset(fusedMem);
+    fusedMem[0xFFFC] = M6502::CPU::INS_LDA_IM;
+    fusedMem[0xFFFD] = 0x84;
+    fusedMem[0xFFFE] = M6502::CPU::INS_STA_ZP;
+    fusedMem[0xFFFF] = 0x42;
+
+    //when:
+    int cyclesUsed = M6502::ExecuteFused<Pair>(fused, 2, fusedMem);
+
+    // then:
+    EXPECT_EQ(cyclesUsed, 2);
+    EXPECT_EQ(fused.PC, 0xFFFE);
+    EXPECT_EQ(fusedMem[0x0042], 0x00);
+}
+
+TEST_F(M6502FusionTest, ProfilerCountsOpcodePairs)
+{
+    // given:
+    std::unique_ptr<M6502::OpcodeProfile> profile(new M6502::OpcodeProfile);
+    plain.Reset(plainMem);
+    plainMem[0xFFFC] = M6502::CPU::INS_LDA_IM;
+    plainMem[0xFFFD] = 0x84;
+    plainMem[0xFFFE] = M6502::CPU::INS_STA_ZP;
+    plainMem[0xFFFF] = 0x42;
+
+    //when:
+    M6502::ExecuteProfiled(plain, 5, plainMem, *profile);
+
+    // then:
+    EXPECT_EQ(profile->Total(), 2u);
+    EXPECT_EQ(profile->Pairs[(M6502::CPU::INS_LDA_IM << 8) | M6502::CPU::INS_STA_ZP], 1u);
+}
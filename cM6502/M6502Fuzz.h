@@ -0,0 +1,197 @@
+#ifndef M6502_FUZZ_H
+#define M6502_FUZZ_H
+#include <cstring>
+#include <memory>
+#include <vector>
+#include "cM6502.h"
+#include "M6502Coverage.h"
+
+// In-process coverage guided fuzzing of guest code.
+//
+// The Fuzzer keeps the CPU and memory it was given as a snapshot. Every run
+// restores it, writes an input of InputSize bytes at InputAddress and runs
+// with coverage until the CPU halts (end the harness with JAM) or Cycles are
+// used up. Inputs that reach new edges, or known edges a new number of
+// times, go into the corpus. New inputs are corpus entries with a few
+// random mutations stacked on each other.
+//
+// Memory is a DirtyMem, which notes the pages written since the last
+// restore, so a restore only copies those back instead of 64KB.
+
+namespace M6502
+{
+    using u64 = unsigned long long;
+    struct DirtyMem;
+    using FuzzCPU = BasicCPU<NMOS6502, DirtyMem>;
+    template<typename CPUType = FuzzCPU> struct Fuzzer;
+}
+
+struct M6502::DirtyMem{
+    static constexpr u32 MAX_MEM = 1024 * 64;
+    static constexpr u32 NUM_PAGES = MAX_MEM / 256;
+    u8 data[MAX_MEM] = {};
+    bool dirty[NUM_PAGES] = {};
+    u8 dirtyPages[NUM_PAGES];
+    u32 dirtyCount = 0;
+
+    void Initialize()
+    {
+        memset(data, 0, MAX_MEM);
+    }
+
+    // Read one Byte
+    u8 operator[](u32 address) const
+    {
+        return data[address];
+    }
+
+    // Write one Byte, marks the page
+    u8& operator[](u32 address)
+    {
+        u8 page = address >> 8;
+        if(!dirty[page]){
+            dirty[page] = true;
+            dirtyPages[dirtyCount++] = page;
+        }
+        return data[address];
+    }
+
+    void WriteWord(u16 value, u16 address)
+    {
+        (*this)[address] = value & 0xFF;
+        (*this)[static_cast<u16>(address + 1)] = (value >> 8);
+    }
+
+    bool IsIOPage(u8 page) const
+    {
+        return false;
+    }
+
+    // copies the pages written since the last restore back from snapshot
+    void Restore(const DirtyMem& snapshot)
+    {
+        for(u32 i = 0; i < dirtyCount; i++){
+            u32 page = dirtyPages[i];
+            memcpy(data + page * 256, snapshot.data + page * 256, 256);
+            dirty[page] = false;
+        }
+        dirtyCount = 0;
+    }
+};
+
+template<typename CPUType>
+struct M6502::Fuzzer{
+    const u16 InputAddress;
+    const u16 InputSize;
+    int Cycles = 100000;
+    u64 Seed = 0x2545F4914F6CDD1Dull;
+
+    std::vector<std::vector<u8>> Corpus;
+    std::unique_ptr<Coverage> Edges{new Coverage};
+    u64 Executions = 0;
+    // runs that did not halt within Cycles
+    u64 Timeouts = 0;
+
+    // state after the last run
+    CPUType CPU;
+    std::unique_ptr<DirtyMem> Mem;
+
+    Fuzzer(const CPUType& cpu, const DirtyMem& mem, u16 inputAddress, u16 inputSize)
+        : InputAddress(inputAddress), InputSize(inputSize), CPU(cpu), Mem(new DirtyMem(mem)),
+          start(cpu), snapshot(new DirtyMem(mem))
+    {
+        Mem->dirtyCount = 0;
+        memset(Mem->dirty, 0, sizeof(Mem->dirty));
+    }
+
+    // Runs one input, true when it found new coverage
+    bool Run(const std::vector<u8>& input)
+    {
+        Mem->Restore(*snapshot);
+        CPU = start;
+        for(u32 i = 0; i < InputSize && i < input.size(); i++){
+            (*Mem)[InputAddress + i] = input[i];
+        }
+        Edges->Clear();
+        ExecuteCovered(CPU, Cycles, *Mem, *Edges);
+        Executions++;
+        Timeouts += !CPU.Halted;
+        return Edges->NewBits();
+    }
+
+    // seeds go into the corpus whatever they cover
+    void AddSeed(std::vector<u8> input)
+    {
+        input.resize(InputSize);
+        Run(input);
+        Corpus.push_back(std::move(input));
+    }
+
+    // runs executions mutated inputs, returns how many went into the corpus
+    u32 Fuzz(u64 executions)
+    {
+        if(Corpus.empty()){
+            AddSeed({});
+        }
+        u32 added = 0;
+        std::vector<u8> input;
+        for(u64 i = 0; i < executions; i++){
+            input = Corpus[Random() % Corpus.size()];
+            Mutate(input);
+            if(Run(input)){
+                Corpus.push_back(input);
+                added++;
+            }
+        }
+        return added;
+    }
+
+private:
+    CPUType start;
+    std::unique_ptr<DirtyMem> snapshot;
+
+    // xorshift64
+    u64 Random()
+    {
+        Seed ^= Seed << 13;
+        Seed ^= Seed >> 7;
+        Seed ^= Seed << 17;
+        return Seed;
+    }
+
+    void Mutate(std::vector<u8>& input)
+    {
+        static constexpr u8 interesting[] = {0x00, 0x01, 0x10, 0x20, 0x40, 0x7F, 0x80, 0x81, 0xFF};
+        if(input.empty()){
+            return;
+        }
+        int mutations = 1 << (Random() % 4);
+        for(int i = 0; i < mutations; i++){
+            u64 random = Random();
+            u8& byte = input[(random >> 8) % input.size()];
+            switch(random % 6){
+                case 0:
+                    byte ^= 1 << (random >> 40 & 7);
+                    break;
+                case 1:
+                    byte = random >> 40;
+                    break;
+                case 2:
+                    byte = interesting[(random >> 40) % sizeof(interesting)];
+                    break;
+                case 3:
+                    byte += (random >> 40) % 35 - 17;
+                    break;
+                case 4:
+                    byte = input[(random >> 40) % input.size()];
+                    break;
+                case 5:{
+                    const std::vector<u8>& other = Corpus[(random >> 40) % Corpus.size()];
+                    byte = other[(random >> 20) % other.size()];
+                    break;
+                }
+            }
+        }
+    }
+};
+#endif
@@ -0,0 +1,145 @@
+#include <cstring>
+#include <memory>
+#include <string>
+#include "gtest/gtest.h"
+#include "M6502Fuzz.h"
+#include "M6502Workloads.h"
+
+namespace
+{
+    // stores $FF to $10 when the input at $0300 is "FUZZ"
+    constexpr M6502::u8 MagicProgram[] = {
+        0xAD, 0x00, 0x03,   // 0200 LDA $0300
+        0xC9, 0x46,         // 0203 CMP #$46
+        0xD0, 0x19,         // 0205 BNE $0220
+        0xAD, 0x01, 0x03,   // 0207 LDA $0301
+        0xC9, 0x55,         // 020A CMP #$55
+        0xD0, 0x12,         // 020C BNE $0220
+        0xAD, 0x02, 0x03,   // 020E LDA $0302
+        0xC9, 0x5A,         // 0211 CMP #$5A
+        0xD0, 0x0B,         // 0213 BNE $0220
+        0xAD, 0x03, 0x03,   // 0215 LDA $0303
+        0xC9, 0x5A,         // 0218 CMP #$5A
+        0xD0, 0x04,         // 021A BNE $0220
+        0xA9, 0xFF,         // 021C LDA #$FF
+        0x85, 0x10,         // 021E STA $10
+        // done
+        0x02,               // 0220 JAM
+    };
+
+    constexpr M6502::u8 LoopProgram[] = {
+        0xA2, 0x03,         // 0200 LDX #$03
+        // loop
+        0xCA,               // 0202 DEX
+        0xD0, 0xFD,         // 0203 BNE $0202
+        0x02,               // 0205 JAM
+    };
+}
+
+class M6502FuzzTest : public testing::Test
+{
+public:
+    std::unique_ptr<M6502::DirtyMem> mem{new M6502::DirtyMem};
+    M6502::FuzzCPU cpu;
+    std::unique_ptr<M6502::Coverage> coverage{new M6502::Coverage};
+
+    template<M6502::u32 N>
+    void Load(const M6502::u8 (&program)[N])
+    {
+        cpu.Reset(*mem);
+        for(M6502::u32 i = 0; i < N; i++){
+            (*mem)[0x0200 + i] = program[i];
+        }
+        cpu.PC = 0x0200;
+    }
+
+    static M6502::u16 Index(M6502::u16 from, M6502::u16 to)
+    {
+        return M6502::Coverage::Location(to) ^ M6502::Coverage::Location(from) >> 1;
+    }
+};
+
+TEST_F(M6502FuzzTest, EveryControlTransferCountsItsEdge)
+{
+    // given:
+    Load(LoopProgram);
+
+    // when:
+    M6502::ExecuteCovered(cpu, 1000, *mem, *coverage);
+
+    // then:
+    EXPECT_TRUE(cpu.Halted);
+    EXPECT_EQ(coverage->Map[Index(0x0203, 0x0202)], 2);
+    EXPECT_EQ(coverage->Map[Index(0x0203, 0x0205)], 1);
+    EXPECT_EQ(coverage->Edges(), 2u);
+    EXPECT_TRUE(coverage->NewBits());
+    EXPECT_FALSE(coverage->NewBits());
+}
+
+TEST_F(M6502FuzzTest, CoveredExecutionMatchesPlainExecution)
+{
+    // given:
+    std::unique_ptr<M6502::Mem> plainMem(new M6502::Mem);
+    M6502::CPU plain;
+    const M6502::Workload& workload = M6502::CorpusWorkloads[0];
+    workload.Setup(plain, *plainMem);
+    workload.Setup(cpu, *mem);
+
+    // when:
+    int plainCycles = plain.Execute(100000, *plainMem);
+    int coveredCycles = M6502::ExecuteCovered(cpu, 100000, *mem, *coverage);
+
+    // then:
+    EXPECT_EQ(coveredCycles, plainCycles);
+    EXPECT_EQ(cpu.PC, plain.PC);
+    EXPECT_EQ(cpu.GetStatus(), plain.GetStatus());
+    EXPECT_EQ(memcmp(mem->data, plainMem->data, M6502::Mem::MAX_MEM), 0);
+    EXPECT_GT(coverage->Edges(), 0u);
+}
+
+TEST_F(M6502FuzzTest, RestoreCopiesBackTheWrittenPages)
+{
+    // given:
+    Load(LoopProgram);
+    M6502::DirtyMem snapshot = *mem;
+    mem->Restore(snapshot);
+
+    // when:
+    (*mem)[0x1234] = 1;
+    (*mem)[0x1250] = 2;
+    (*mem)[0x8000] = 3;
+    M6502::u32 dirty = mem->dirtyCount;
+    mem->Restore(snapshot);
+
+    // then:
+    EXPECT_EQ(dirty, 2u);
+    EXPECT_EQ(mem->dirtyCount, 0u);
+    EXPECT_EQ(memcmp(mem->data, snapshot.data, M6502::DirtyMem::MAX_MEM), 0);
+}
+
+TEST_F(M6502FuzzTest, FuzzerFindsTheMagicInput)
+{
+    // given:
+    Load(MagicProgram);
+    M6502::Fuzzer<> fuzzer(cpu, *mem, 0x0300, 4);
+    fuzzer.Cycles = 1000;
+    fuzzer.AddSeed({'A', 'A', 'A', 'A'});
+
+    // when:
+    bool found = false;
+    while(!found && fuzzer.Executions < 2000000){
+        fuzzer.Fuzz(10000);
+        for(const std::vector<M6502::u8>& input : fuzzer.Corpus){
+            found |= std::string(input.begin(), input.end()) == "FUZZ";
+        }
+    }
+
+    // then:
+    EXPECT_TRUE(found);
+    EXPECT_EQ(fuzzer.Corpus.size(), 5u);
+    EXPECT_EQ(fuzzer.Timeouts, 0u);
+    fuzzer.Run({'F', 'U', 'Z', 'Z'});
+    EXPECT_EQ(fuzzer.Mem->data[0x10], 0xFF);
+    fuzzer.Run({'A', 'A', 'A', 'A'});
+    EXPECT_EQ(fuzzer.Mem->data[0x10], 0);
+}
@@ -0,0 +1,137 @@
+#include <cstring>
+#include <memory>
+#include <string>
+#include "gtest/gtest.h"
+#include "M6502Fusion.h"
+#include "M6502HostCounters.h"
+#include "M6502Opcodes.h"
+#include "M6502Workloads.h"
+
+class M6502HostCounterTest : public testing::Test
+{
+public:
+    M6502::Mem plainMem;
+    M6502::Mem countedMem;
+    M6502::CPU plain;
+    M6502::CPU counted;
+    std::unique_ptr<M6502::HostProfile> profile{new M6502::HostProfile};
+};
+
+TEST_F(M6502HostCounterTest, CountedExecutionMatchesPlainExecution)
+{
+    // given:
+    std::unique_ptr<M6502::OpcodeProfile> opcodes(new M6502::OpcodeProfile);
+    const M6502::Workload& workload = M6502::CorpusWorkloads[0];
+    workload.Setup(plain, plainMem);
+    workload.Setup(counted, countedMem);
+    profile->Window = 3;
+    profile->Period = 50;
+
+    // when:
+    int plainCycles = M6502::ExecuteProfiled(plain, 100000, plainMem, *opcodes);
+    int countedCycles = M6502::ExecuteCounted(counted, 100000, countedMem, *profile);
+
+    // then:
+    EXPECT_EQ(plainCycles, countedCycles);
+    EXPECT_EQ(plain.PC, counted.PC);
+    EXPECT_EQ(plain.A, counted.A);
+    EXPECT_EQ(plain.Y, counted.Y);
+    EXPECT_EQ(plain.GetStatus(), counted.GetStatus());
+    EXPECT_EQ(memcmp(plainMem.data, countedMem.data, M6502::Mem::MAX_MEM), 0);
+    for(int i = 0; i < 256; i++){
+        EXPECT_EQ(opcodes->Counts[i], profile->Executed[i]);
+    }
+}
+
+TEST_F(M6502HostCounterTest, OnlyTheWindowOfEveryPeriodIsSampled)
+{
+    if(profile->Counters.Opened == 0){
+        GTEST_SKIP() << "perf_event_open is not available";
+    }
+    // given:
+    profile->Window = 2;
+    profile->Period = 10;
+    M6502::CorpusWorkloads[0].Setup(counted, countedMem);
+
+    // when:
+    M6502::ExecuteCounted(counted, 100000, countedMem, *profile);
+
+    // then:
+    M6502::u64 executed = 0;
+    M6502::u64 sampled = 0;
+    for(int i = 0; i < 256; i++){
+        executed += profile->Executed[i];
+        sampled += profile->Sampled[i];
+    }
+    EXPECT_GE(sampled, executed / 10 * 2);
+    EXPECT_LE(sampled, executed / 10 * 2 + 2);
+}
+
+TEST_F(M6502HostCounterTest, TheWindowMovesAroundThePeriod)
+{
+    // given:
+    profile->Window = 2;
+    profile->Period = 10;
+    int sampledAt[10] = {};
+
+    // when:
+    for(int period = 0; period < 1000; period++){
+        int sampled = 0;
+        for(int i = 0; i < 10; i++){
+            if(profile->Next()){
+                sampledAt[i]++;
+                sampled++;
+            }
+        }
+        ASSERT_EQ(sampled, 2);
+    }
+
+    // then:
+    for(int i = 0; i < 10; i++){
+        EXPECT_GT(sampledAt[i], 50) << i;
+    }
+}
+
+template<typename CPUType>
+void ExpectLengthsMatchExecution()
+{
+    for(int opcode = 0; opcode < 256; opcode++){
+        const M6502::OpcodeInfo& info = M6502::OpcodeInfo::Of<CPUType>(opcode);
+        std::string mnemonic = info.Mnemonic;
+        // these do not continue with the next instruction, or are not emulated
+        if(mnemonic == "BRK" || mnemonic == "JMP" || mnemonic == "JSR" || mnemonic == "RTS" ||
+           mnemonic == "RTI" || mnemonic == "JAM" || mnemonic == "STP" || mnemonic == "WAI" ||
+           mnemonic == "ANE" || mnemonic == "SHA" || mnemonic == "TAS" || mnemonic == "SHX" ||
+           mnemonic == "SHY" || mnemonic == "LXA"){
+            continue;
+        }
+        M6502::Mem mem;
+        CPUType cpu;
+        cpu.Reset(mem);
+        cpu.PC = 0x0200;
+        mem[0x0200] = opcode;
+        cpu.Execute(1, mem);
+        EXPECT_EQ(cpu.PC, 0x0200 + M6502::OpcodeInfo::Length(info.Operand)) << "opcode " << opcode;
+    }
+}
+
+TEST_F(M6502HostCounterTest, OpcodeLengthsMatchTheEmulatedInstructions)
+{
+    ExpectLengthsMatchExecution<M6502::CPU>();
+    ExpectLengthsMatchExecution<M6502::CPU65C02>();
+}
+
+TEST_F(M6502HostCounterTest, OpcodeInfoDependsOnTheVariant)
+{
+    // given:
+    const M6502::OpcodeInfo& nmos = M6502::OpcodeInfo::Of<M6502::CPU>(M6502::CPU::INS_INC_ACC);
+    const M6502::OpcodeInfo& cmos = M6502::OpcodeInfo::Of<M6502::CPU65C02>(M6502::CPU::INS_INC_ACC);
+    const M6502::OpcodeInfo& indirect = M6502::OpcodeInfo::Of<M6502::CPU>(M6502::CPU::INS_LDA_INDY);
+
+    // then:
+    EXPECT_STREQ(nmos.Mnemonic, "NOP");
+    EXPECT_STREQ(cmos.Mnemonic, "INC");
+    EXPECT_EQ(cmos.Operand, M6502::OpcodeInfo::ACC);
+    EXPECT_STREQ(indirect.Mnemonic, "LDA");
+    EXPECT_STREQ(M6502::OpcodeInfo::ModeName(indirect.Operand), "(zp),y");
+}
@@ -0,0 +1,242 @@
+#ifndef M6502_HOST_COUNTERS_H
+#define M6502_HOST_COUNTERS_H
+#include "cM6502.h"
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Host cycles, branch misses and cache misses per emulated opcode.
+//
+// ExecuteCounted runs like Execute but reads a perf_event counter group
+// before and after single instructions and adds the difference to the
+// opcode. Only Window instructions in a row of every Period are measured,
+// so the cost of the reads (a system call each) stays a bounded share of
+// the run. That cost is measured by Calibrate and taken off again.
+//
+// Where the window starts in a period is random, so loops whose length
+// divides the period do not always show the same instructions.
+//
+// Without hardware counters (other systems, virtual machines,
+// perf_event_paranoid) the software task clock in nanoseconds is used
+// instead, and when even that fails nothing is measured.
+
+namespace M6502
+{
+    using u64 = unsigned long long;
+    struct HostCounters;
+    struct HostProfile;
+}
+
+struct M6502::HostCounters{
+    static constexpr int COUNTERS = 3;
+
+    const char* Names[COUNTERS] = {};
+    int Opened = 0;
+    bool Hardware = false;
+
+    HostCounters()
+    {
+        Open();
+    }
+
+    HostCounters(const HostCounters&) = delete;
+    HostCounters& operator=(const HostCounters&) = delete;
+
+    ~HostCounters()
+    {
+        Close();
+    }
+
+    bool Open()
+    {
+        Close();
+#ifdef __linux__
+        static const u64 hardware[COUNTERS] = {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_BRANCH_MISSES, PERF_COUNT_HW_CACHE_MISSES
+        };
+        static const char* hardwareNames[COUNTERS] = {"cycles", "branch-misses", "cache-misses"};
+        for(int i = 0; i < COUNTERS; i++){
+            if(!OpenCounter(PERF_TYPE_HARDWARE, hardware[i])){
+                Close();
+                break;
+            }
+            Names[i] = hardwareNames[i];
+        }
+        Hardware = Opened == COUNTERS;
+        if(!Hardware && OpenCounter(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK)){
+            Names[0] = "task-clock ns";
+        }
+        if(Opened > 0){
+            ioctl(fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+#endif
+        return Opened > 0;
+    }
+
+    void Close()
+    {
+#ifdef __linux__
+        for(int i = 0; i < Opened; i++){
+            close(fds[i]);
+        }
+#endif
+        Opened = 0;
+        Hardware = false;
+        for(const char*& name : Names){
+            name = nullptr;
+        }
+    }
+
+    // counters that are not open read as 0
+    bool Read(u64 (&values)[COUNTERS]) const
+    {
+        for(u64& value : values){
+            value = 0;
+        }
+#ifdef __linux__
+        u64 group[1 + COUNTERS];
+        if(Opened > 0 && read(fds[0], group, sizeof(u64) * (1 + Opened)) > 0){
+            for(int i = 0; i < Opened; i++){
+                values[i] = group[1 + i];
+            }
+            return true;
+        }
+#endif
+        return false;
+    }
+
+private:
+    int fds[COUNTERS] = {-1, -1, -1};
+
+#ifdef __linux__
+    bool OpenCounter(u32 type, u64 config)
+    {
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP;
+        attr.disabled = Opened == 0;
+        int fd = syscall(SYS_perf_event_open, &attr, 0, -1, Opened == 0 ? -1 : fds[0], 0);
+        if(fd < 0){
+            return false;
+        }
+        fds[Opened++] = fd;
+        return true;
+    }
+#endif
+};
+
+struct M6502::HostProfile{
+    static constexpr int COUNTERS = HostCounters::COUNTERS;
+
+    HostCounters Counters;
+    int Window = 16;
+    int Period = 65536;
+
+    u64 Executed[256] = {};
+    u64 Sampled[256] = {};
+    u64 Cost[256][COUNTERS] = {};
+    // mean counts of a measurement around nothing
+    double Overhead[COUNTERS] = {};
+    int Position = 0;
+    // where the window starts in the current period
+    int Start = 0;
+    u64 Seed = 0x2545F4914F6CDD1Dull;
+
+    void Calibrate(int samples = 20000)
+    {
+        u64 total[COUNTERS] = {};
+        u64 before[COUNTERS], after[COUNTERS];
+        int measured = 0;
+        for(int i = 0; i < samples; i++){
+            if(Counters.Read(before) && Counters.Read(after)){
+                for(int c = 0; c < COUNTERS; c++){
+                    total[c] += after[c] - before[c];
+                }
+                measured++;
+            }
+        }
+        for(int c = 0; c < COUNTERS; c++){
+            Overhead[c] = measured > 0 ? static_cast<double>(total[c]) / measured : 0;
+        }
+    }
+
+    // whether the next instruction is inside a sampling window
+    bool Next()
+    {
+        bool inside = Position >= Start && Position - Start < Window;
+        if(++Position >= Period){
+            Position = 0;
+            // xorshift64
+            Seed ^= Seed << 13;
+            Seed ^= Seed >> 7;
+            Seed ^= Seed << 17;
+            Start = Period > Window ? static_cast<int>(Seed % (Period - Window + 1)) : 0;
+        }
+        return inside;
+    }
+
+    void Add(u8 ins, const u64 (&before)[COUNTERS], const u64 (&after)[COUNTERS])
+    {
+        Sampled[ins]++;
+        for(int c = 0; c < COUNTERS; c++){
+            Cost[ins][c] += after[c] - before[c];
+        }
+    }
+
+    // mean host count per instruction of the opcodes in the mask
+    double PerInstruction(const bool (&opcodes)[256], int counter) const
+    {
+        u64 samples = 0;
+        u64 cost = 0;
+        for(int i = 0; i < 256; i++){
+            if(opcodes[i]){
+                samples += Sampled[i];
+                cost += Cost[i][counter];
+            }
+        }
+        if(samples == 0){
+            return 0;
+        }
+        double mean = static_cast<double>(cost) / samples - Overhead[counter];
+        return mean > 0 ? mean : 0;
+    }
+
+    double PerInstruction(u8 opcode, int counter) const
+    {
+        bool opcodes[256] = {};
+        opcodes[opcode] = true;
+        return PerInstruction(opcodes, counter);
+    }
+};
+
+namespace M6502
+{
+    template<typename CPUType>
+    int ExecuteCounted(CPUType& cpu, int cycles, typename CPUType::MemoryType& mem, HostProfile& profile)
+    {
+        constexpr int COUNTERS = HostProfile::COUNTERS;
+        const typename CPUType::OpTable& ops = OpcodeTable<CPUType>::Table;
+        int requestedCycles = cycles;
+        u64 before[COUNTERS], after[COUNTERS];
+        while(cycles > 0){
+            bool sample = profile.Next() && profile.Counters.Read(before);
+            u8 ins = cpu.FetchByte(mem);
+            cycles -= ops.Cycles[ins];
+            ops.Handlers[ins](cpu, mem, cycles);
+            if(sample && profile.Counters.Read(after)){
+                profile.Add(ins, before, after);
+            }
+            profile.Executed[ins]++;
+        }
+        return cpu.Used(requestedCycles, cycles);
+    }
+}
+#endif
@@ -0,0 +1,138 @@
+#include <cstring>
+#include <functional>
+#include "gtest/gtest.h"
+#include "M6502Idioms.h"
+
+class M6502IdiomTest : public testing::Test
+{
+public:
+    M6502::Mem plainMem;
+    M6502::Mem idiomMem;
+    M6502::CPU plain;
+    M6502::CPU idiom;
+
+    // program at 0x0200 followed by JMP to itself
+    void Load(M6502::Mem& mem, M6502::CPU& cpu, u_int16_t load, std::initializer_list<M6502::u8> program)
+    {
+        cpu.Reset(mem);
+        u_int16_t address = load;
+        for(M6502::u8 value : program){
+            mem[address++] = value;
+        }
+        mem[address] = M6502::CPU::INS_JMP_ABS;
+        mem[address + 1] = address & 0xFF;
+        mem[address + 2] = address >> 8;
+        cpu.PC = load;
+        for(int i = 0; i < 0x100; i++){
+            mem[0x10F0 + i] = i * 7;
+            mem[0x40F0 + i] = i * 7;
+        }
+    }
+
+    // interpretation and idioms agree for budgets that end before, inside
+    // and after the loop
+    void ExpectSameAsInterpretation(std::function<void(M6502::Mem&, M6502::CPU&)> setup)
+    {
+        for(int budget = 1; budget < 6000; budget += 13){
+            setup(plainMem, plain);
+            setup(idiomMem, idiom);
+            int plainCycles = plain.Execute(budget, plainMem);
+            int idiomCycles = M6502::ExecuteIdioms(idiom, budget, idiomMem);
+            ASSERT_EQ(plainCycles, idiomCycles) << "budget " << budget;
+            ASSERT_EQ(plain.PC, idiom.PC) << "budget " << budget;
+            ASSERT_EQ(plain.A, idiom.A) << "budget " << budget;
+            ASSERT_EQ(plain.X, idiom.X) << "budget " << budget;
+            ASSERT_EQ(plain.Y, idiom.Y) << "budget " << budget;
+            ASSERT_EQ(plain.GetStatus(), idiom.GetStatus()) << "budget " << budget;
+            ASSERT_EQ(memcmp(plainMem.data, idiomMem.data, M6502::Mem::MAX_MEM), 0) << "budget " << budget;
+        }
+    }
+};
+
+TEST_F(M6502IdiomTest, CopyIndirectYMatchesInterpretation)
+{
+    for(M6502::u8 y : {0x00, 0x80, 0xFF}){
+        ExpectSameAsInterpretation([y, this](M6502::Mem& mem, M6502::CPU& cpu){
+            Load(mem, cpu, 0x0200, {0xB1, 0x80, 0x91, 0x82, 0xC8, 0xD0, 0xF9});
+            mem.WriteWord(0x10F0, 0x80);
+            mem.WriteWord(0x3000, 0x82);
+            cpu.Y = y;
+        });
+    }
+}
+
+TEST_F(M6502IdiomTest, OverlappingForwardCopyFallsBackToInterpretation)
+{
+    ExpectSameAsInterpretation([this](M6502::Mem& mem, M6502::CPU& cpu){
+        Load(mem, cpu, 0x0200, {0xB1, 0x80, 0x91, 0x82, 0xC8, 0xD0, 0xF9});
+        mem.WriteWord(0x10F0, 0x80);
+        mem.WriteWord(0x10F1, 0x82);
+    });
+}
+
+TEST_F(M6502IdiomTest, CopyOverItsOwnPointerFallsBackToInterpretation)
+{
+    ExpectSameAsInterpretation([this](M6502::Mem& mem, M6502::CPU& cpu){
+        Load(mem, cpu, 0x0200, {0xB1, 0x80, 0x91, 0x82, 0xC8, 0xD0, 0xF9});
+        mem.WriteWord(0x10F0, 0x80);
+        mem.WriteWord(0x0000, 0x82);
+    });
+}
+
+TEST_F(M6502IdiomTest, CopyAbsoluteXMatchesInterpretation)
+{
+    ExpectSameAsInterpretation([this](M6502::Mem& mem, M6502::CPU& cpu){
+        Load(mem, cpu, 0x0200, {0xBD, 0xF0, 0x10, 0x9D, 0x00, 0x30, 0xE8, 0xD0, 0xF7});
+        cpu.X = 0x10;
+    });
+}
+
+TEST_F(M6502IdiomTest, FillAbsoluteXWithBranchAcrossAPageMatchesInterpretation)
+{
+    ExpectSameAsInterpretation([this](M6502::Mem& mem, M6502::CPU& cpu){
+        Load(mem, cpu, 0x02FC, {0x9D, 0xF8, 0x30, 0xE8, 0xD0, 0xFA});
+        cpu.A = 0x5A;
+    });
+}
+
+TEST_F(M6502IdiomTest, FillIndirectYMatchesInterpretation)
+{
+    ExpectSameAsInterpretation([this](M6502::Mem& mem, M6502::CPU& cpu){
+        Load(mem, cpu, 0x0200, {0x91, 0x82, 0xC8, 0xD0, 0xFB});
+        mem.WriteWord(0x3000, 0x82);
+        cpu.A = 0xA5;
+        cpu.Y = 0x20;
+    });
+}
+
+TEST_F(M6502IdiomTest, CompareIndirectYMatchesInterpretation)
+{
+    for(int mismatch : {-1, 0x00, 0x40, 0xFF}){
+        ExpectSameAsInterpretation([mismatch, this](M6502::Mem& mem, M6502::CPU& cpu){
+            Load(mem, cpu, 0x0200, {0xB1, 0x80, 0xD1, 0x82, 0xD0, 0x05, 0xC8, 0xD0, 0xF7, 0xA9, 0x01});
+            mem.WriteWord(0x10F0, 0x80);
+            mem.WriteWord(0x40F0, 0x82);
+            if(mismatch >= 0){
+                mem[0x40F0 + mismatch] ^= 0x81;
+            }
+        });
+    }
+}
+
+TEST_F(M6502IdiomTest, WholeCopyLoopIsChargedTheExactCycles)
+{
+    // given:
+    Load(idiomMem, idiom, 0x0200, {0xB1, 0x80, 0x91, 0x82, 0xC8, 0xD0, 0xF9});
+    idiomMem.WriteWord(0x1000, 0x80);
+    idiomMem.WriteWord(0x3000, 0x82);
+    constexpr int EXPECTED_CYCLES = 256 * (5 + 6 + 2) + 255 * 3 + 2;
+
+    //when:
+    int cyclesUsed = M6502::ExecuteIdioms(idiom, EXPECTED_CYCLES, idiomMem);
+
+    // then:
+    EXPECT_EQ(cyclesUsed, EXPECTED_CYCLES);
+    EXPECT_EQ(idiom.PC, 0x0207);
+    EXPECT_EQ(idiomMem[0x3000 + 0xF0], 0x00);
+    EXPECT_EQ(idiomMem[0x3000 + 0xF5], 0x23);
+}
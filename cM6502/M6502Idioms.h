@@ -0,0 +1,302 @@
+#ifndef M6502_IDIOMS_H
+#define M6502_IDIOMS_H
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+#include "cM6502.h"
+
+// Block copy, fill and compare loops run as host memmove/memset/memcmp.
+//
+// The first opcode of each loop gets a handler that checks the bytes that
+// follow it. When they are one of the loops below and it is safe, the whole
+// loop runs at once and is charged the exact cycles it would have taken:
+//
+//   copy     LDA (src),Y / STA (dst),Y / INY / BNE
+//   copy     LDA src,X / STA dst,X / INX / BNE
+//   fill     STA dst,X / INX / BNE
+//   fill     STA (dst),Y / INY / BNE
+//   compare  LDA (a),Y / CMP (b),Y / BNE out / INY / BNE
+//
+// It is not safe when a range wraps the address space, touches an I/O page,
+// writes over the loop or its pointers, or is a forward overlapping copy.
+// It is also skipped when the cycle budget would run out inside the loop,
+// Execute stops there. Otherwise the normal handler runs. Needs a memory
+// type with a flat data array, i.e. Mem.
+
+namespace M6502
+{
+    template<typename CPUType, typename Base = OpcodeTable<CPUType>> struct IdiomOpcodeTable;
+}
+
+template<typename CPUType, typename Base>
+struct M6502::IdiomOpcodeTable{
+    using MemType = typename CPUType::MemoryType;
+    static constexpr const typename CPUType::OpTable& BaseTable = Base::Table;
+
+    static bool Matches(const MemType& mem, u16 address, std::initializer_list<int> pattern)
+    {
+        for(int value : pattern){
+            if(value >= 0 && mem.data[address] != value){
+                return false;
+            }
+            address++;
+        }
+        return true;
+    }
+
+    static u16 Pointer(const MemType& mem, u8 address)
+    {
+        return mem.data[address] | (mem.data[static_cast<u8>(address + 1)] << 8);
+    }
+
+    // inside the address space and clear of I/O pages
+    static bool Plain(const MemType& mem, u32 start, u32 length)
+    {
+        if(start + length > MemType::MAX_MEM){
+            return false;
+        }
+        for(u32 page = start >> 8; page <= (start + length - 1) >> 8; page++){
+            if(mem.IsIOPage(page)){
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static bool Overlaps(u32 a, u32 aLength, u32 b, u32 bLength)
+    {
+        return a < b + bLength && b < a + aLength;
+    }
+
+    // zero page pointers wrap, so check both bytes on their own
+    static bool OverlapsPointer(u32 start, u32 length, u8 pointer)
+    {
+        return Overlaps(start, length, pointer, 1) || Overlaps(start, length, static_cast<u8>(pointer + 1), 1);
+    }
+
+    // indexed reads from base + index for index in [first, last] that cross a page
+    static int PagePenalties(u16 base, u32 first, u32 last)
+    {
+        u32 low = base & 0xFF;
+        if(low == 0){
+            return 0;
+        }
+        u32 crossing = std::max(first, 0x100 - low);
+        return crossing > last ? 0 : last - crossing + 1;
+    }
+
+    // a taken branch whose target is on another page costs one more cycle
+    static int BranchTaken(const MemType& mem, u16 branch)
+    {
+        u16 next = branch + 2;
+        u16 target = next + static_cast<s8>(mem.data[static_cast<u16>(branch + 1)]);
+        return (target & 0xFF00) != (next & 0xFF00) ? 4 : 3;
+    }
+
+    // cycles are only charged when the interpreter would have reached the
+    // last instruction of the loop with cycles left
+    static bool Budget(int& cycles, u8 opcode, int total, int lastInstruction)
+    {
+        int available = cycles + BaseTable.Cycles[opcode];
+        if(available - (total - lastInstruction) <= 0){
+            return false;
+        }
+        cycles = available - total;
+        return true;
+    }
+
+    static void CountedOut(CPUType& cpu, u8& index, u16 next)
+    {
+        index = 0;
+        cpu.Z = 1;
+        cpu.N = 0;
+        cpu.PC = next;
+    }
+
+    static bool CopyIndirectY(CPUType& cpu, MemType& mem, int& cycles, u16 start)
+    {
+        if(!Matches(mem, start, {0xB1, -1, 0x91, -1, 0xC8, 0xD0, 0xF9})){
+            return false;
+        }
+        u8 srcPointer = mem.data[start + 1];
+        u8 dstPointer = mem.data[start + 3];
+        u16 src = Pointer(mem, srcPointer);
+        u16 dst = Pointer(mem, dstPointer);
+        u32 count = 0x100 - cpu.Y;
+        u32 from = src + cpu.Y;
+        u32 to = dst + cpu.Y;
+        if(!Plain(mem, from, count) || !Plain(mem, to, count) ||
+           Overlaps(to, count, start, 7) ||
+           OverlapsPointer(to, count, srcPointer) || OverlapsPointer(to, count, dstPointer) ||
+           (to > from && to < from + count)){
+            return false;
+        }
+        int total = count * (5 + 6 + 2) + PagePenalties(src, cpu.Y, 0xFF) +
+                    (count - 1) * BranchTaken(mem, start + 5) + 2;
+        if(!Budget(cycles, 0xB1, total, 2)){
+            return false;
+        }
+        memmove(mem.data + to, mem.data + from, count);
+        cpu.A = mem.data[from + count - 1];
+        CountedOut(cpu, cpu.Y, start + 7);
+        return true;
+    }
+
+    static bool CompareIndirectY(CPUType& cpu, MemType& mem, int& cycles, u16 start)
+    {
+        if(!Matches(mem, start, {0xB1, -1, 0xD1, -1, 0xD0, -1, 0xC8, 0xD0, 0xF7})){
+            return false;
+        }
+        u16 a = Pointer(mem, mem.data[start + 1]);
+        u16 b = Pointer(mem, mem.data[start + 3]);
+        u32 count = 0x100 - cpu.Y;
+        u32 first = a + cpu.Y;
+        u32 second = b + cpu.Y;
+        if(!Plain(mem, first, count) || !Plain(mem, second, count)){
+            return false;
+        }
+        u32 equal = std::mismatch(mem.data + first, mem.data + first + count, mem.data + second).first - (mem.data + first);
+        u32 last = equal < count ? cpu.Y + equal : 0xFF;
+        int loopBack = BranchTaken(mem, start + 7);
+        if(equal < count){
+            // the mismatching iteration leaves through the first BNE
+            int exit = BranchTaken(mem, start + 4);
+            int total = equal * (5 + 5 + 2 + 2 + loopBack) + 5 + 5 + exit +
+                        PagePenalties(a, cpu.Y, last) + PagePenalties(b, cpu.Y, last);
+            if(!Budget(cycles, 0xB1, total, exit)){
+                return false;
+            }
+            cpu.A = mem.data[first + equal];
+            cpu.Compare(cpu.A, mem.data[second + equal]);
+            cpu.Y = last;
+            cpu.PC = start + 6 + static_cast<s8>(mem.data[start + 5]);
+            return true;
+        }
+        int total = count * (5 + 5 + 2 + 2) + (count - 1) * loopBack + 2 +
+                    PagePenalties(a, cpu.Y, last) + PagePenalties(b, cpu.Y, last);
+        if(!Budget(cycles, 0xB1, total, 2)){
+            return false;
+        }
+        cpu.A = mem.data[first + count - 1];
+        cpu.C = 1;
+        CountedOut(cpu, cpu.Y, start + 9);
+        return true;
+    }
+
+    static bool CopyAbsoluteX(CPUType& cpu, MemType& mem, int& cycles, u16 start)
+    {
+        if(!Matches(mem, start, {0xBD, -1, -1, 0x9D, -1, -1, 0xE8, 0xD0, 0xF7})){
+            return false;
+        }
+        u16 src = mem.data[start + 1] | (mem.data[start + 2] << 8);
+        u16 dst = mem.data[start + 4] | (mem.data[start + 5] << 8);
+        u32 count = 0x100 - cpu.X;
+        u32 from = src + cpu.X;
+        u32 to = dst + cpu.X;
+        if(!Plain(mem, from, count) || !Plain(mem, to, count) ||
+           Overlaps(to, count, start, 9) || (to > from && to < from + count)){
+            return false;
+        }
+        int total = count * (4 + 5 + 2) + PagePenalties(src, cpu.X, 0xFF) +
+                    (count - 1) * BranchTaken(mem, start + 7) + 2;
+        if(!Budget(cycles, 0xBD, total, 2)){
+            return false;
+        }
+        memmove(mem.data + to, mem.data + from, count);
+        cpu.A = mem.data[from + count - 1];
+        CountedOut(cpu, cpu.X, start + 9);
+        return true;
+    }
+
+    static bool FillAbsoluteX(CPUType& cpu, MemType& mem, int& cycles, u16 start)
+    {
+        if(!Matches(mem, start, {0x9D, -1, -1, 0xE8, 0xD0, 0xFA})){
+            return false;
+        }
+        u16 dst = mem.data[start + 1] | (mem.data[start + 2] << 8);
+        u32 count = 0x100 - cpu.X;
+        u32 to = dst + cpu.X;
+        if(!Plain(mem, to, count) || Overlaps(to, count, start, 6)){
+            return false;
+        }
+        int total = count * (5 + 2) + (count - 1) * BranchTaken(mem, start + 4) + 2;
+        if(!Budget(cycles, 0x9D, total, 2)){
+            return false;
+        }
+        memset(mem.data + to, cpu.A, count);
+        CountedOut(cpu, cpu.X, start + 6);
+        return true;
+    }
+
+    static bool FillIndirectY(CPUType& cpu, MemType& mem, int& cycles, u16 start)
+    {
+        if(!Matches(mem, start, {0x91, -1, 0xC8, 0xD0, 0xFB})){
+            return false;
+        }
+        u8 dstPointer = mem.data[start + 1];
+        u16 dst = Pointer(mem, dstPointer);
+        u32 count = 0x100 - cpu.Y;
+        u32 to = dst + cpu.Y;
+        if(!Plain(mem, to, count) || Overlaps(to, count, start, 5) || OverlapsPointer(to, count, dstPointer)){
+            return false;
+        }
+        int total = count * (6 + 2) + (count - 1) * BranchTaken(mem, start + 3) + 2;
+        if(!Budget(cycles, 0x91, total, 2)){
+            return false;
+        }
+        memset(mem.data + to, cpu.A, count);
+        CountedOut(cpu, cpu.Y, start + 5);
+        return true;
+    }
+
+    static void LDAIndirectY(CPUType& cpu, MemType& mem, int& cycles)
+    {
+        u16 start = cpu.PC - 1;
+        if(!CopyIndirectY(cpu, mem, cycles, start) && !CompareIndirectY(cpu, mem, cycles, start)){
+            BaseTable.Handlers[0xB1](cpu, mem, cycles);
+        }
+    }
+
+    static void LDAAbsoluteX(CPUType& cpu, MemType& mem, int& cycles)
+    {
+        if(!CopyAbsoluteX(cpu, mem, cycles, cpu.PC - 1)){
+            BaseTable.Handlers[0xBD](cpu, mem, cycles);
+        }
+    }
+
+    static void STAAbsoluteX(CPUType& cpu, MemType& mem, int& cycles)
+    {
+        if(!FillAbsoluteX(cpu, mem, cycles, cpu.PC - 1)){
+            BaseTable.Handlers[0x9D](cpu, mem, cycles);
+        }
+    }
+
+    static void STAIndirectY(CPUType& cpu, MemType& mem, int& cycles)
+    {
+        if(!FillIndirectY(cpu, mem, cycles, cpu.PC - 1)){
+            BaseTable.Handlers[0x91](cpu, mem, cycles);
+        }
+    }
+
+    static constexpr typename CPUType::OpTable Build()
+    {
+        typename CPUType::OpTable table = BaseTable;
+        table.Handlers[0xB1] = &LDAIndirectY;
+        table.Handlers[0xBD] = &LDAAbsoluteX;
+        table.Handlers[0x9D] = &STAAbsoluteX;
+        table.Handlers[0x91] = &STAIndirectY;
+        return table;
+    }
+
+    static constexpr typename CPUType::OpTable Table = Build();
+};
+
+namespace M6502
+{
+    template<typename CPUType>
+    int ExecuteIdioms(CPUType& cpu, int cycles, typename CPUType::MemoryType& mem)
+    {
+        return cpu.Execute(IdiomOpcodeTable<CPUType>::Table, cycles, mem);
+    }
+}
+#endif
@@ -0,0 +1,327 @@
+#ifndef M6502_MEMO_H
+#define M6502_MEMO_H
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "cM6502.h"
+
+// Memoized subroutine calls.
+//
+// ExecuteMemoized runs a JSR through a second CPU on a TracingMem that
+// logs every byte read before it was written, and the final value of every
+// byte written, until the matching RTS. Opcode and operand fetches are
+// reads too, so the log also covers the code of the subroutine.
+//
+// A later JSR from the same PC with the same registers and flags is
+// replayed from the cache when every logged read still has its logged
+// value: the writes are stored, the registers set and the recorded cycles
+// charged. Execution is deterministic, so a call that reads the same bytes
+// takes the same path. Changing the code or any input of a subroutine
+// therefore invalidates its entries by itself.
+//
+// Subroutines that read more than MaxReads bytes, write more than
+// MaxWrites, run longer than MaxInstructions, touch an I/O page, or execute
+// BRK, WAI or a halting opcode are not memoized again, nor are subroutines
+// that missed MaxMisses times without a single hit.
+
+namespace M6502
+{
+    using u64 = unsigned long long;
+    struct MemoLog;
+    template<typename MemType> struct TracingMem;
+    template<typename CPUType> struct SubroutineMemo;
+}
+
+struct M6502::MemoLog{
+    std::vector<std::pair<u16, u8>> Reads;
+    std::vector<std::pair<u16, u8>> Writes;
+    size_t MaxReads = 64;
+    size_t MaxWrites = 32;
+    bool Overflow = false;
+    bool IO = false;
+
+    static std::pair<u16, u8>* Find(std::vector<std::pair<u16, u8>>& log, u16 address)
+    {
+        for(std::pair<u16, u8>& entry : log){
+            if(entry.first == address){
+                return &entry;
+            }
+        }
+        return nullptr;
+    }
+
+    void Read(u16 address, u8 value)
+    {
+        if(Overflow || Find(Writes, address) || Find(Reads, address)){
+            return;
+        }
+        Reads.push_back({address, value});
+        Overflow = Reads.size() > MaxReads;
+    }
+
+    void Write(u16 address, u8 value)
+    {
+        if(Overflow){
+            return;
+        }
+        if(std::pair<u16, u8>* entry = Find(Writes, address)){
+            entry->second = value;
+            return;
+        }
+        Writes.push_back({address, value});
+        Overflow = Writes.size() > MaxWrites;
+    }
+};
+
+// Passes every access on to the memory it wraps and logs it
+template<typename MemType>
+struct M6502::TracingMem{
+    static constexpr u32 MAX_MEM = MemType::MAX_MEM;
+
+    MemType& Target;
+    MemoLog& Log;
+
+    struct Byte{
+        TracingMem& mem;
+        u32 address;
+
+        Byte& operator=(u8 value)
+        {
+            mem.Log.IO |= mem.Target.IsIOPage(address >> 8);
+            mem.Log.Write(address, value);
+            mem.Target[address] = value;
+            return *this;
+        }
+    };
+
+    u8 operator[](u32 address) const
+    {
+        u8 value = static_cast<const MemType&>(Target)[address];
+        Log.IO |= Target.IsIOPage(address >> 8);
+        Log.Read(address, value);
+        return value;
+    }
+
+    Byte operator[](u32 address)
+    {
+        return {*this, address};
+    }
+
+    bool IsIOPage(u8 page) const
+    {
+        return Target.IsIOPage(page);
+    }
+};
+
+template<typename CPUType>
+struct M6502::SubroutineMemo{
+    using MemType = typename CPUType::MemoryType;
+    using TraceCPU = BasicCPU<typename CPUType::VariantType, TracingMem<MemType>>;
+
+    struct Entry{
+        bool Used = false;
+        u64 Age = 0;
+        // registers at the JSR
+        u16 PC = 0;
+        u8 SP = 0, A = 0, X = 0, Y = 0, P = 0;
+        std::vector<std::pair<u16, u8>> Reads;
+        std::vector<std::pair<u16, u8>> Writes;
+        // registers after the RTS
+        u16 OutPC = 0;
+        u8 OutSP = 0, OutA = 0, OutX = 0, OutY = 0, OutP = 0;
+        int Cycles = 0;
+        // cycles used before the RTS started
+        int BeforeLast = 0;
+    };
+
+    struct Stats{
+        u64 Calls = 0;
+        u64 Hits = 0;
+        u64 Misses = 0;
+        bool Disabled = false;
+    };
+
+    std::vector<Entry> Entries;
+    std::unordered_map<u16, Stats> Subroutines;
+    size_t MaxReads = 64;
+    size_t MaxWrites = 32;
+    int MaxInstructions = 10000;
+    u64 MaxMisses = 64;
+
+    u64 Stored = 0;
+
+    explicit SubroutineMemo(size_t capacity = 1024) : Entries(capacity < WAYS ? WAYS : capacity)
+    {
+    }
+
+    // entries are kept in sets of WAYS, a new one replaces the oldest
+    static constexpr size_t WAYS = 4;
+
+    Entry* Set(const CPUType& cpu)
+    {
+        u32 hash = cpu.PC ^ (cpu.A << 16) ^ (cpu.X << 8) ^ (cpu.Y << 24) ^ (cpu.SP << 4) ^ (cpu.GetStatus() << 12);
+        hash = (hash ^ (hash >> 16)) * 0x45D9F3Bu;
+        hash ^= hash >> 16;
+        return &Entries[hash % (Entries.size() / WAYS) * WAYS];
+    }
+
+    static bool Matches(const Entry& entry, const CPUType& cpu, const MemType& mem)
+    {
+        if(!entry.Used || entry.PC != cpu.PC || entry.SP != cpu.SP || entry.A != cpu.A ||
+           entry.X != cpu.X || entry.Y != cpu.Y || entry.P != cpu.GetStatus()){
+            return false;
+        }
+        for(const std::pair<u16, u8>& read : entry.Reads){
+            if(mem[read.first] != read.second){
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template<typename To, typename From>
+    static void CopyState(To& to, const From& from)
+    {
+        to.PC = from.PC;
+        to.SP = from.SP;
+        to.A = from.A;
+        to.X = from.X;
+        to.Y = from.Y;
+        to.SetStatus(from.GetStatus());
+        to.B = from.B;
+        to.Halted = from.Halted;
+        to.Waiting = from.Waiting;
+        to.Leftover = from.Leftover;
+    }
+
+    // Runs the JSR at PC and the subroutine it calls, returns false when the
+    // caller has to run the JSR instead
+    bool Call(CPUType& cpu, MemType& mem, int& cycles)
+    {
+        u16 target = cpu.ReadWord(cpu.PC + 1, mem);
+        Stats& stats = Subroutines[target];
+        stats.Calls++;
+        if(stats.Disabled){
+            return false;
+        }
+        Entry* set = Set(cpu);
+        for(size_t way = 0; way < WAYS; way++){
+            const Entry& entry = set[way];
+            if(!Matches(entry, cpu, mem)){
+                continue;
+            }
+            // Execute would stop inside the subroutine
+            if(cycles - entry.BeforeLast <= 0){
+                return false;
+            }
+            Replay(entry, cpu, mem);
+            cycles -= entry.Cycles;
+            stats.Hits++;
+            return true;
+        }
+        if(++stats.Misses > MaxMisses && stats.Hits == 0){
+            stats.Disabled = true;
+            return false;
+        }
+        Entry* oldest = set;
+        for(size_t way = 1; way < WAYS; way++){
+            if(set[way].Age < oldest->Age){
+                oldest = &set[way];
+            }
+        }
+        Record(*oldest, stats, cpu, mem, cycles);
+        return true;
+    }
+
+    void Replay(const Entry& entry, CPUType& cpu, MemType& mem)
+    {
+        for(const std::pair<u16, u8>& write : entry.Writes){
+            mem[write.first] = write.second;
+        }
+        cpu.PC = entry.OutPC;
+        cpu.SP = entry.OutSP;
+        cpu.A = entry.OutA;
+        cpu.X = entry.OutX;
+        cpu.Y = entry.OutY;
+        cpu.SetStatus(entry.OutP);
+    }
+
+    // runs the call for real, stops with the budget like Execute
+    void Record(Entry& entry, Stats& stats, CPUType& cpu, MemType& mem, int& cycles)
+    {
+        const typename TraceCPU::OpTable& ops = OpcodeTable<TraceCPU>::Table;
+        MemoLog log;
+        log.MaxReads = MaxReads;
+        log.MaxWrites = MaxWrites;
+        TracingMem<MemType> traced{mem, log};
+        TraceCPU trace;
+        CopyState(trace, cpu);
+
+        Entry recorded;
+        recorded.PC = cpu.PC;
+        recorded.SP = cpu.SP;
+        recorded.A = cpu.A;
+        recorded.X = cpu.X;
+        recorded.Y = cpu.Y;
+        recorded.P = cpu.GetStatus();
+        int start = cycles;
+        bool returned = false;
+        bool memoizable = true;
+        for(int instructions = 0; cycles > 0; instructions++){
+            recorded.BeforeLast = start - cycles;
+            u8 ins = trace.FetchByte(traced);
+            cycles -= ops.Cycles[ins];
+            ops.Handlers[ins](trace, traced, cycles);
+            if(ins == CPUType::INS_BRK || trace.Halted || trace.Waiting || log.Overflow ||
+               instructions >= MaxInstructions){
+                memoizable = false;
+                break;
+            }
+            if(ins == CPUType::INS_RTS && trace.SP == recorded.SP){
+                returned = true;
+                break;
+            }
+        }
+        CopyState(cpu, trace);
+
+        if(!memoizable || log.IO){
+            stats.Disabled = true;
+            return;
+        }
+        if(!returned){
+            return;
+        }
+        recorded.Used = true;
+        recorded.Age = ++Stored;
+        recorded.Reads = std::move(log.Reads);
+        recorded.Writes = std::move(log.Writes);
+        recorded.OutPC = cpu.PC;
+        recorded.OutSP = cpu.SP;
+        recorded.OutA = cpu.A;
+        recorded.OutX = cpu.X;
+        recorded.OutY = cpu.Y;
+        recorded.OutP = cpu.GetStatus();
+        recorded.Cycles = start - cycles;
+        entry = std::move(recorded);
+    }
+};
+
+namespace M6502
+{
+    template<typename CPUType>
+    int ExecuteMemoized(CPUType& cpu, int cycles, typename CPUType::MemoryType& mem, SubroutineMemo<CPUType>& memo)
+    {
+        const typename CPUType::OpTable& ops = OpcodeTable<CPUType>::Table;
+        int requestedCycles = cycles;
+        while(cycles > 0){
+            if(cpu.ReadByte(cpu.PC, mem) == CPUType::INS_JSR && memo.Call(cpu, mem, cycles)){
+                continue;
+            }
+            u8 ins = cpu.FetchByte(mem);
+            cycles -= ops.Cycles[ins];
+            ops.Handlers[ins](cpu, mem, cycles);
+        }
+        return cpu.Used(requestedCycles, cycles);
+    }
+}
+#endif
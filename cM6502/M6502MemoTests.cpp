@@ -0,0 +1,179 @@
+#include <cstring>
+#include <memory>
+#include "gtest/gtest.h"
+#include "M6502Memo.h"
+
+namespace
+{
+        // multiplies the pairs at $0300/$0308 through a JSR, products to $21/$31
+    constexpr M6502::u8 MultiplyProgram[] = {
+        0xA2, 0x00,         // 0200 LDX #$00
+        // loop
+        0xBD, 0x00, 0x03,   // 0202 LDA $0300,X
+        0x85, 0x10,         // 0205 STA $10
+        0xBD, 0x08, 0x03,   // 0207 LDA $0308,X
+        0x85, 0x11,         // 020A STA $11
+        0x20, 0x1F, 0x02,   // 020C JSR $021F
+        0x95, 0x21,         // 020F STA $21,X
+        0xA5, 0x10,         // 0211 LDA $10
+        0x95, 0x31,         // 0213 STA $31,X
+        0xE8,               // 0215 INX
+        0xE0, 0x08,         // 0216 CPX #$08
+        0xD0, 0xE8,         // 0218 BNE $0202
+        0xE6, 0x20,         // 021A INC $20
+        0x4C, 0x00, 0x02,   // 021C JMP $0200
+        // mul
+        0xA9, 0x00,         // 021F LDA #$00
+        0xA0, 0x08,         // 0221 LDY #$08
+        0x46, 0x10,         // 0223 LSR $10
+        // shift
+        0x90, 0x03,         // 0225 BCC $022A
+        0x18,               // 0227 CLC
+        0x65, 0x11,         // 0228 ADC $11
+        // skip
+        0x6A,               // 022A ROR A
+        0x66, 0x10,         // 022B ROR $10
+        0x88,               // 022D DEY
+        0xD0, 0xF5,         // 022E BNE $0225
+        0x60,               // 0230 RTS
+    };
+    constexpr M6502::u16 MULTIPLY = 0x021F;
+}
+
+class M6502MemoTest : public testing::Test
+{
+public:
+    M6502::Mem plainMem;
+    M6502::Mem memoMem;
+    M6502::CPU plain;
+    M6502::CPU memoized;
+    std::unique_ptr<M6502::SubroutineMemo<M6502::CPU>> memo{new M6502::SubroutineMemo<M6502::CPU>};
+
+    virtual void SetUp()
+    {
+        Load(plain, plainMem);
+        Load(memoized, memoMem);
+    }
+
+    void Load(M6502::CPU& cpu, M6502::Mem& mem)
+    {
+        cpu.Reset(mem);
+        for(M6502::u32 i = 0; i < sizeof(MultiplyProgram); i++){
+            mem[0x0200 + i] = MultiplyProgram[i];
+        }
+        for(int i = 0; i < 16; i++){
+            mem[0x0300 + i] = 17 * i + 3;
+        }
+        cpu.PC = 0x0200;
+    }
+
+    void Poke(M6502::u16 address, M6502::u8 value)
+    {
+        plainMem[address] = value;
+        memoMem[address] = value;
+    }
+
+    void Run(int slice, int slices)
+    {
+        for(int i = 0; i < slices; i++){
+            int plainCycles = plain.Execute(slice, plainMem);
+            int memoCycles = M6502::ExecuteMemoized(memoized, slice, memoMem, *memo);
+            ASSERT_EQ(plainCycles, memoCycles);
+        }
+    }
+
+    void ExpectSameState()
+    {
+        EXPECT_EQ(plain.PC, memoized.PC);
+        EXPECT_EQ(plain.SP, memoized.SP);
+        EXPECT_EQ(plain.A, memoized.A);
+        EXPECT_EQ(plain.X, memoized.X);
+        EXPECT_EQ(plain.Y, memoized.Y);
+        EXPECT_EQ(plain.GetStatus(), memoized.GetStatus());
+        EXPECT_EQ(memcmp(plainMem.data, memoMem.data, M6502::Mem::MAX_MEM), 0);
+    }
+};
+
+TEST_F(M6502MemoTest, MemoizedExecutionMatchesPlainExecutionForAnySliceSize)
+{
+    // calls only replay when the whole call fits in the slice
+    for(int slice : {1, 2, 3, 5, 8, 13, 100, 150, 1000, 4099}){
+        SCOPED_TRACE(slice);
+        SetUp();
+        memo.reset(new M6502::SubroutineMemo<M6502::CPU>);
+        Run(slice, 300000 / slice);
+        ExpectSameState();
+    }
+    EXPECT_GT(memo->Subroutines[MULTIPLY].Hits, 0u);
+}
+
+TEST_F(M6502MemoTest, WholeCallsAreReplayedFromTheCache)
+{
+        // when:
+    Run(100000, 1);
+
+        // then:
+    ExpectSameState();
+    const auto& stats = memo->Subroutines[MULTIPLY];
+    EXPECT_FALSE(stats.Disabled);
+    // 8 pairs, the first call has the carry of the reset
+    EXPECT_EQ(stats.Misses, 9u);
+    EXPECT_GT(stats.Hits, stats.Calls * 9 / 10);
+}
+
+TEST_F(M6502MemoTest, ChangedInputsAreNotReplayed)
+{
+        // given:
+    Run(100000, 1);
+
+        // when:
+    Poke(0x0303, 0xFF);
+    Poke(0x030B, 0xFF);
+    Run(100000, 1);
+
+        // then:
+    ExpectSameState();
+    EXPECT_EQ(memoMem[0x24], 0xFE);
+    EXPECT_EQ(memoMem[0x34], 0x01);
+}
+
+TEST_F(M6502MemoTest, ChangedCodeIsNotReplayed)
+{
+        // given:
+    Run(100000, 1);
+
+        // when: the multiply adds with carry set
+    Poke(0x0227, M6502::CPU::INS_SEC);
+    Run(100000, 1);
+
+        // then:
+    ExpectSameState();
+}
+
+TEST_F(M6502MemoTest, SubroutinesOverTheReadLimitAreNotMemoized)
+{
+        // given:
+    memo->MaxReads = 4;
+
+        // when:
+    Run(100000, 1);
+
+        // then:
+    ExpectSameState();
+    EXPECT_TRUE(memo->Subroutines[MULTIPLY].Disabled);
+    EXPECT_EQ(memo->Subroutines[MULTIPLY].Hits, 0u);
+}
+
+TEST_F(M6502MemoTest, CallThatHaltsCountsOnlyTheCyclesUsed)
+{
+        // given:
+    Poke(MULTIPLY, M6502::CPU::INS_NOP);
+    Poke(MULTIPLY + 1, M6502::CPU::INS_JAM);
+
+        // when:
+    Run(1000, 1);
+
+        // then:
+    ExpectSameState();
+    EXPECT_TRUE(memoized.Halted);
+}
@@ -0,0 +1,153 @@
+#ifndef M6502_OPCODES_H
+#define M6502_OPCODES_H
+#include "cM6502.h"
+
+// Mnemonic and operand mode of every opcode, for reports and tools. The NMOS
+// table uses the common names for the undocumented opcodes.
+
+namespace M6502
+{
+    struct OpcodeInfo;
+}
+
+struct M6502::OpcodeInfo{
+    enum Mode{
+        IMP, ACC, IMM, ZP, ZPX, ZPY, ABS, ABSX, ABSY, IND, INDX, INDY,
+        ZPI, ABSXI, REL, ZPREL      // 65C02 (zp), (abs,x) and BBR/BBS
+    };
+    static constexpr int MODES = ZPREL + 1;
+
+    const char* Mnemonic;
+    Mode Operand;
+
+    static const OpcodeInfo NMOS[256];
+    static const OpcodeInfo CMOS[256];
+
+    static const char* ModeName(Mode mode)
+    {
+        static const char* names[MODES] = {
+            "implied", "A", "#imm", "zp", "zp,x", "zp,y", "abs", "abs,x", "abs,y", "(abs)", "(zp,x)", "(zp),y",
+            "(zp)", "(abs,x)", "rel", "zp,rel"
+        };
+        return names[mode];
+    }
+
+    // instruction length in bytes
+    static constexpr int Length(Mode mode)
+    {
+        switch(mode){
+            case IMP: case ACC: return 1;
+            case ABS: case ABSX: case ABSY: case IND: case ABSXI: case ZPREL: return 3;
+            default: return 2;
+        }
+    }
+
+    template<typename CPUType>
+    static const OpcodeInfo& Of(u8 opcode)
+    {
+        return CPUType::VariantType::CMOS ? CMOS[opcode] : NMOS[opcode];
+    }
+};
+
+inline const M6502::OpcodeInfo M6502::OpcodeInfo::NMOS[256] = {
+    // 00
+    {"BRK", IMP}, {"ORA", INDX}, {"JAM", IMP}, {"SLO", INDX}, {"NOP", ZP}, {"ORA", ZP}, {"ASL", ZP}, {"SLO", ZP},
+    {"PHP", IMP}, {"ORA", IMM}, {"ASL", ACC}, {"ANC", IMM}, {"NOP", ABS}, {"ORA", ABS}, {"ASL", ABS}, {"SLO", ABS},
+    // 10
+    {"BPL", REL}, {"ORA", INDY}, {"JAM", IMP}, {"SLO", INDY}, {"NOP", ZPX}, {"ORA", ZPX}, {"ASL", ZPX}, {"SLO", ZPX},
+    {"CLC", IMP}, {"ORA", ABSY}, {"NOP", IMP}, {"SLO", ABSY}, {"NOP", ABSX}, {"ORA", ABSX}, {"ASL", ABSX}, {"SLO", ABSX},
+    // 20
+    {"JSR", ABS}, {"AND", INDX}, {"JAM", IMP}, {"RLA", INDX}, {"BIT", ZP}, {"AND", ZP}, {"ROL", ZP}, {"RLA", ZP},
+    {"PLP", IMP}, {"AND", IMM}, {"ROL", ACC}, {"ANC", IMM}, {"BIT", ABS}, {"AND", ABS}, {"ROL", ABS}, {"RLA", ABS},
+    // 30
+    {"BMI", REL}, {"AND", INDY}, {"JAM", IMP}, {"RLA", INDY}, {"NOP", ZPX}, {"AND", ZPX}, {"ROL", ZPX}, {"RLA", ZPX},
+    {"SEC", IMP}, {"AND", ABSY}, {"NOP", IMP}, {"RLA", ABSY}, {"NOP", ABSX}, {"AND", ABSX}, {"ROL", ABSX}, {"RLA", ABSX},
+    // 40
+    {"RTI", IMP}, {"EOR", INDX}, {"JAM", IMP}, {"SRE", INDX}, {"NOP", ZP}, {"EOR", ZP}, {"LSR", ZP}, {"SRE", ZP},
+    {"PHA", IMP}, {"EOR", IMM}, {"LSR", ACC}, {"ALR", IMM}, {"JMP", ABS}, {"EOR", ABS}, {"LSR", ABS}, {"SRE", ABS},
+    // 50
+    {"BVC", REL}, {"EOR", INDY}, {"JAM", IMP}, {"SRE", INDY}, {"NOP", ZPX}, {"EOR", ZPX}, {"LSR", ZPX}, {"SRE", ZPX},
+    {"CLI", IMP}, {"EOR", ABSY}, {"NOP", IMP}, {"SRE", ABSY}, {"NOP", ABSX}, {"EOR", ABSX}, {"LSR", ABSX}, {"SRE", ABSX},
+    // 60
+    {"RTS", IMP}, {"ADC", INDX}, {"JAM", IMP}, {"RRA", INDX}, {"NOP", ZP}, {"ADC", ZP}, {"ROR", ZP}, {"RRA", ZP},
+    {"PLA", IMP}, {"ADC", IMM}, {"ROR", ACC}, {"ARR", IMM}, {"JMP", IND}, {"ADC", ABS}, {"ROR", ABS}, {"RRA", ABS},
+    // 70
+    {"BVS", REL}, {"ADC", INDY}, {"JAM", IMP}, {"RRA", INDY}, {"NOP", ZPX}, {"ADC", ZPX}, {"ROR", ZPX}, {"RRA", ZPX},
+    {"SEI", IMP}, {"ADC", ABSY}, {"NOP", IMP}, {"RRA", ABSY}, {"NOP", ABSX}, {"ADC", ABSX}, {"ROR", ABSX}, {"RRA", ABSX},
+    // 80
+    {"NOP", IMM}, {"STA", INDX}, {"NOP", IMM}, {"SAX", INDX}, {"STY", ZP}, {"STA", ZP}, {"STX", ZP}, {"SAX", ZP},
+    {"DEY", IMP}, {"NOP", IMM}, {"TXA", IMP}, {"ANE", IMM}, {"STY", ABS}, {"STA", ABS}, {"STX", ABS}, {"SAX", ABS},
+    // 90
+    {"BCC", REL}, {"STA", INDY}, {"JAM", IMP}, {"SHA", INDY}, {"STY", ZPX}, {"STA", ZPX}, {"STX", ZPY}, {"SAX", ZPY},
+    {"TYA", IMP}, {"STA", ABSY}, {"TXS", IMP}, {"TAS", ABSY}, {"SHY", ABSX}, {"STA", ABSX}, {"SHX", ABSY}, {"SHA", ABSY},
+    // A0
+    {"LDY", IMM}, {"LDA", INDX}, {"LDX", IMM}, {"LAX", INDX}, {"LDY", ZP}, {"LDA", ZP}, {"LDX", ZP}, {"LAX", ZP},
+    {"TAY", IMP}, {"LDA", IMM}, {"TAX", IMP}, {"LXA", IMM}, {"LDY", ABS}, {"LDA", ABS}, {"LDX", ABS}, {"LAX", ABS},
+    // B0
+    {"BCS", REL}, {"LDA", INDY}, {"JAM", IMP}, {"LAX", INDY}, {"LDY", ZPX}, {"LDA", ZPX}, {"LDX", ZPY}, {"LAX", ZPY},
+    {"CLV", IMP}, {"LDA", ABSY}, {"TSX", IMP}, {"LAS", ABSY}, {"LDY", ABSX}, {"LDA", ABSX}, {"LDX", ABSY}, {"LAX", ABSY},
+    // C0
+    {"CPY", IMM}, {"CMP", INDX}, {"NOP", IMM}, {"DCP", INDX}, {"CPY", ZP}, {"CMP", ZP}, {"DEC", ZP}, {"DCP", ZP},
+    {"INY", IMP}, {"CMP", IMM}, {"DEX", IMP}, {"SBX", IMM}, {"CPY", ABS}, {"CMP", ABS}, {"DEC", ABS}, {"DCP", ABS},
+    // D0
+    {"BNE", REL}, {"CMP", INDY}, {"JAM", IMP}, {"DCP", INDY}, {"NOP", ZPX}, {"CMP", ZPX}, {"DEC", ZPX}, {"DCP", ZPX},
+    {"CLD", IMP}, {"CMP", ABSY}, {"NOP", IMP}, {"DCP", ABSY}, {"NOP", ABSX}, {"CMP", ABSX}, {"DEC", ABSX}, {"DCP", ABSX},
+    // E0
+    {"CPX", IMM}, {"SBC", INDX}, {"NOP", IMM}, {"ISC", INDX}, {"CPX", ZP}, {"SBC", ZP}, {"INC", ZP}, {"ISC", ZP},
+    {"INX", IMP}, {"SBC", IMM}, {"NOP", IMP}, {"SBC", IMM}, {"CPX", ABS}, {"SBC", ABS}, {"INC", ABS}, {"ISC", ABS},
+    // F0
+    {"BEQ", REL}, {"SBC", INDY}, {"JAM", IMP}, {"ISC", INDY}, {"NOP", ZPX}, {"SBC", ZPX}, {"INC", ZPX}, {"ISC", ZPX},
+    {"SED", IMP}, {"SBC", ABSY}, {"NOP", IMP}, {"ISC", ABSY}, {"NOP", ABSX}, {"SBC", ABSX}, {"INC", ABSX}, {"ISC", ABSX},
+};
+
+inline const M6502::OpcodeInfo M6502::OpcodeInfo::CMOS[256] = {
+    // 00
+    {"BRK", IMP}, {"ORA", INDX}, {"NOP", IMM}, {"NOP", IMP}, {"TSB", ZP}, {"ORA", ZP}, {"ASL", ZP}, {"RMB0", ZP},
+    {"PHP", IMP}, {"ORA", IMM}, {"ASL", ACC}, {"NOP", IMP}, {"TSB", ABS}, {"ORA", ABS}, {"ASL", ABS}, {"BBR0", ZPREL},
+    // 10
+    {"BPL", REL}, {"ORA", INDY}, {"ORA", ZPI}, {"NOP", IMP}, {"TRB", ZP}, {"ORA", ZPX}, {"ASL", ZPX}, {"RMB1", ZP},
+    {"CLC", IMP}, {"ORA", ABSY}, {"INC", ACC}, {"NOP", IMP}, {"TRB", ABS}, {"ORA", ABSX}, {"ASL", ABSX}, {"BBR1", ZPREL},
+    // 20
+    {"JSR", ABS}, {"AND", INDX}, {"NOP", IMM}, {"NOP", IMP}, {"BIT", ZP}, {"AND", ZP}, {"ROL", ZP}, {"RMB2", ZP},
+    {"PLP", IMP}, {"AND", IMM}, {"ROL", ACC}, {"NOP", IMP}, {"BIT", ABS}, {"AND", ABS}, {"ROL", ABS}, {"BBR2", ZPREL},
+    // 30
+    {"BMI", REL}, {"AND", INDY}, {"AND", ZPI}, {"NOP", IMP}, {"BIT", ZPX}, {"AND", ZPX}, {"ROL", ZPX}, {"RMB3", ZP},
+    {"SEC", IMP}, {"AND", ABSY}, {"DEC", ACC}, {"NOP", IMP}, {"BIT", ABSX}, {"AND", ABSX}, {"ROL", ABSX}, {"BBR3", ZPREL},
+    // 40
+    {"RTI", IMP}, {"EOR", INDX}, {"NOP", IMM}, {"NOP", IMP}, {"NOP", ZP}, {"EOR", ZP}, {"LSR", ZP}, {"RMB4", ZP},
+    {"PHA", IMP}, {"EOR", IMM}, {"LSR", ACC}, {"NOP", IMP}, {"JMP", ABS}, {"EOR", ABS}, {"LSR", ABS}, {"BBR4", ZPREL},
+    // 50
+    {"BVC", REL}, {"EOR", INDY}, {"EOR", ZPI}, {"NOP", IMP}, {"NOP", ZPX}, {"EOR", ZPX}, {"LSR", ZPX}, {"RMB5", ZP},
+    {"CLI", IMP}, {"EOR", ABSY}, {"PHY", IMP}, {"NOP", IMP}, {"NOP", ABS}, {"EOR", ABSX}, {"LSR", ABSX}, {"BBR5", ZPREL},
+    // 60
+    {"RTS", IMP}, {"ADC", INDX}, {"NOP", IMM}, {"NOP", IMP}, {"STZ", ZP}, {"ADC", ZP}, {"ROR", ZP}, {"RMB6", ZP},
+    {"PLA", IMP}, {"ADC", IMM}, {"ROR", ACC}, {"NOP", IMP}, {"JMP", IND}, {"ADC", ABS}, {"ROR", ABS}, {"BBR6", ZPREL},
+    // 70
+    {"BVS", REL}, {"ADC", INDY}, {"ADC", ZPI}, {"NOP", IMP}, {"STZ", ZPX}, {"ADC", ZPX}, {"ROR", ZPX}, {"RMB7", ZP},
+    {"SEI", IMP}, {"ADC", ABSY}, {"PLY", IMP}, {"NOP", IMP}, {"JMP", ABSXI}, {"ADC", ABSX}, {"ROR", ABSX}, {"BBR7", ZPREL},
+    // 80
+    {"BRA", REL}, {"STA", INDX}, {"NOP", IMM}, {"NOP", IMP}, {"STY", ZP}, {"STA", ZP}, {"STX", ZP}, {"SMB0", ZP},
+    {"DEY", IMP}, {"BIT", IMM}, {"TXA", IMP}, {"NOP", IMP}, {"STY", ABS}, {"STA", ABS}, {"STX", ABS}, {"BBS0", ZPREL},
+    // 90
+    {"BCC", REL}, {"STA", INDY}, {"STA", ZPI}, {"NOP", IMP}, {"STY", ZPX}, {"STA", ZPX}, {"STX", ZPY}, {"SMB1", ZP},
+    {"TYA", IMP}, {"STA", ABSY}, {"TXS", IMP}, {"NOP", IMP}, {"STZ", ABS}, {"STA", ABSX}, {"STZ", ABSX}, {"BBS1", ZPREL},
+    // A0
+    {"LDY", IMM}, {"LDA", INDX}, {"LDX", IMM}, {"NOP", IMP}, {"LDY", ZP}, {"LDA", ZP}, {"LDX", ZP}, {"SMB2", ZP},
+    {"TAY", IMP}, {"LDA", IMM}, {"TAX", IMP}, {"NOP", IMP}, {"LDY", ABS}, {"LDA", ABS}, {"LDX", ABS}, {"BBS2", ZPREL},
+    // B0
+    {"BCS", REL}, {"LDA", INDY}, {"LDA", ZPI}, {"NOP", IMP}, {"LDY", ZPX}, {"LDA", ZPX}, {"LDX", ZPY}, {"SMB3", ZP},
+    {"CLV", IMP}, {"LDA", ABSY}, {"TSX", IMP}, {"NOP", IMP}, {"LDY", ABSX}, {"LDA", ABSX}, {"LDX", ABSY}, {"BBS3", ZPREL},
+    // C0
+    {"CPY", IMM}, {"CMP", INDX}, {"NOP", IMM}, {"NOP", IMP}, {"CPY", ZP}, {"CMP", ZP}, {"DEC", ZP}, {"SMB4", ZP},
+    {"INY", IMP}, {"CMP", IMM}, {"DEX", IMP}, {"WAI", IMP}, {"CPY", ABS}, {"CMP", ABS}, {"DEC", ABS}, {"BBS4", ZPREL},
+    // D0
+    {"BNE", REL}, {"CMP", INDY}, {"CMP", ZPI}, {"NOP", IMP}, {"NOP", ZPX}, {"CMP", ZPX}, {"DEC", ZPX}, {"SMB5", ZP},
+    {"CLD", IMP}, {"CMP", ABSY}, {"PHX", IMP}, {"STP", IMP}, {"NOP", ABS}, {"CMP", ABSX}, {"DEC", ABSX}, {"BBS5", ZPREL},
+    // E0
+    {"CPX", IMM}, {"SBC", INDX}, {"NOP", IMM}, {"NOP", IMP}, {"CPX", ZP}, {"SBC", ZP}, {"INC", ZP}, {"SMB6", ZP},
+    {"INX", IMP}, {"SBC", IMM}, {"NOP", IMP}, {"NOP", IMP}, {"CPX", ABS}, {"SBC", ABS}, {"INC", ABS}, {"BBS6", ZPREL},
+    // F0
+    {"BEQ", REL}, {"SBC", INDY}, {"SBC", ZPI}, {"NOP", IMP}, {"NOP", ZPX}, {"SBC", ZPX}, {"INC", ZPX}, {"SMB7", ZP},
+    {"SED", IMP}, {"SBC", ABSY}, {"PLX", IMP}, {"NOP", IMP}, {"NOP", ABS}, {"SBC", ABSX}, {"INC", ABSX}, {"BBS7", ZPREL},
+};
+#endif
@@ -0,0 +1,217 @@
+#ifndef M6502_PACING_H
+#define M6502_PACING_H
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <ctime>
+#include <thread>
+#include "cM6502.h"
+
+// Runs the CPU at a fixed frequency in real time.
+//
+// Pacer executes bursts of BurstCycles and after each one waits for the
+// wall clock time at which those cycles are due. Deadlines are counted from
+// the start of the run and the cycles actually used, so neither an
+// instruction running over a burst nor a late wake up adds up to drift.
+// The wait sleeps with clock_nanosleep until Spin before the deadline and
+// spins for the rest, the sleep alone wakes up too late by far too much.
+//
+// A run that falls more than MaxLag behind (the host was busy elsewhere)
+// moves its start instead of catching up at full speed.
+
+namespace M6502
+{
+    using u64 = unsigned long long;
+    struct PacingStats;
+    struct Pacer;
+}
+
+struct M6502::PacingStats{
+    u64 Bursts = 0;
+    u64 Resyncs = 0;
+    long long Cycles = 0;
+    // nanoseconds
+    long long Elapsed = 0;
+    long long Emulating = 0;
+    long long ThreadTime = 0;
+    // how late the bursts started against their deadlines in nanoseconds,
+    // counted in buckets 1/16 of a power of two wide
+    static constexpr int SUB_BUCKETS = 16;
+    std::array<u64, 60 * SUB_BUCKETS> Lateness{};
+    long long MaxLateness = 0;
+
+    void Record(long long lateness)
+    {
+        lateness = std::max(lateness, 0LL);
+        Lateness[Bucket(lateness)]++;
+        MaxLateness = std::max(MaxLateness, lateness);
+    }
+
+    static int Bucket(long long lateness)
+    {
+        if(lateness < SUB_BUCKETS){
+            return static_cast<int>(lateness);
+        }
+        int exponent = 4;
+        while(lateness >> (exponent + 1)){
+            exponent++;
+        }
+        return (exponent - 3) * SUB_BUCKETS + static_cast<int>((lateness >> (exponent - 4)) & (SUB_BUCKETS - 1));
+    }
+
+    // the highest lateness counted in bucket
+    static long long BucketTop(int bucket)
+    {
+        if(bucket < SUB_BUCKETS){
+            return bucket;
+        }
+        int exponent = bucket / SUB_BUCKETS + 3;
+        long long step = 1LL << (exponent - 4);
+        return (SUB_BUCKETS + bucket % SUB_BUCKETS) * step + step - 1;
+    }
+
+    double Frequency() const
+    {
+        return Elapsed > 0 ? Cycles * 1e9 / Elapsed : 0;
+    }
+
+    // share of the wall clock time the thread was on a host CPU, spinning
+    // included
+    double Utilisation() const
+    {
+        return Elapsed > 0 ? double(ThreadTime) / Elapsed : 0;
+    }
+
+    // share of the wall clock time spent executing instructions
+    double Load() const
+    {
+        return Elapsed > 0 ? double(Emulating) / Elapsed : 0;
+    }
+
+    // percentile between 0 and 100 of the lateness, rounded up to the top
+    // of its bucket
+    long long Jitter(double percentile) const
+    {
+        u64 count = 0;
+        for(u64 counted : Lateness){
+            count += counted;
+        }
+        if(count == 0){
+            return 0;
+        }
+        u64 rank = std::min(count - 1, u64(percentile / 100 * count));
+        u64 below = 0;
+        for(size_t bucket = 0; bucket < Lateness.size(); bucket++){
+            below += Lateness[bucket];
+            if(below > rank){
+                return std::min(BucketTop(static_cast<int>(bucket)), MaxLateness);
+            }
+        }
+        return MaxLateness;
+    }
+};
+
+struct M6502::Pacer{
+    double Frequency = 1e6;
+    int BurstCycles = 1000;
+    // nanoseconds
+    long long Spin = 100000;
+    long long MaxLag = 100000000;
+
+    PacingStats Stats;
+
+    // monotonic clock in nanoseconds
+    static long long Now()
+    {
+#ifdef __linux__
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return now.tv_sec * 1000000000LL + now.tv_nsec;
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    static long long ThreadTime()
+    {
+#ifdef __linux__
+        timespec now;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+        return now.tv_sec * 1000000000LL + now.tv_nsec;
+#else
+        // process time, the closest there is
+        return static_cast<long long>(clock() * (1e9 / CLOCKS_PER_SEC));
+#endif
+    }
+
+    static void SleepUntil(long long deadline)
+    {
+#ifdef __linux__
+        timespec until;
+        until.tv_sec = deadline / 1000000000LL;
+        until.tv_nsec = deadline % 1000000000LL;
+        while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, nullptr) == EINTR){
+        }
+#else
+        std::this_thread::sleep_for(std::chrono::nanoseconds(deadline - Now()));
+#endif
+    }
+
+    // returns the time it was when the wait ended
+    long long WaitUntil(long long deadline) const
+    {
+        long long now = Now();
+        if(deadline - now > Spin){
+            SleepUntil(deadline - Spin);
+            now = Now();
+        }
+        while(now < deadline){
+            now = Now();
+        }
+        return now;
+    }
+
+    // Runs for cycles or until the CPU halts, returns the cycles used. Runs
+    // nothing unless Frequency and BurstCycles are positive.
+    template<typename CPUType>
+    long long Run(CPUType& cpu, typename CPUType::MemoryType& mem, long long cycles)
+    {
+        if(!(Frequency > 0) || BurstCycles <= 0){
+            return 0;
+        }
+        long long threadStart = ThreadTime();
+        long long runStart = Now();
+        long long start = runStart;
+        // cycles counted from start
+        long long paced = 0;
+        long long used = 0;
+        long long now = runStart;
+        while(used < cycles && !cpu.Halted){
+            int burst = static_cast<int>(std::min<long long>(BurstCycles, cycles - used));
+            int executed = cpu.Execute(burst, mem);
+            long long executedAt = Now();
+            Stats.Emulating += executedAt - now;
+            used += executed;
+            paced += executed;
+
+            long long deadline = start + static_cast<long long>(paced * 1e9 / Frequency);
+            if(executedAt - deadline > MaxLag){
+                start = executedAt;
+                paced = 0;
+                Stats.Resyncs++;
+                now = executedAt;
+                continue;
+            }
+            now = WaitUntil(deadline);
+            Stats.Record(now - deadline);
+            Stats.Bursts++;
+        }
+        Stats.Cycles += used;
+        Stats.Elapsed += now - runStart;
+        Stats.ThreadTime += ThreadTime() - threadStart;
+        return used;
+    }
+};
+#endif
@@ -0,0 +1,101 @@
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include "gtest/gtest.h"
+#include "M6502Pacing.h"
+#include "M6502Workloads.h"
+
+class M6502PacingTest : public testing::Test
+{
+public:
+    std::unique_ptr<M6502::Mem> plainMem{new M6502::Mem};
+    std::unique_ptr<M6502::Mem> pacedMem{new M6502::Mem};
+    M6502::CPU plain;
+    M6502::CPU paced;
+    M6502::Pacer pacer;
+};
+
+TEST_F(M6502PacingTest, PacedRunTakesItsCyclesInWallClockTime)
+{
+    // given:
+    const M6502::Workload& workload = M6502::CorpusWorkloads[0];
+    workload.Setup(plain, *plainMem);
+    workload.Setup(paced, *pacedMem);
+    pacer.Frequency = 1e6;
+    pacer.BurstCycles = 1000;
+
+    // when:
+    long long pacedCycles = pacer.Run(paced, *pacedMem, 20000);
+    long long plainCycles = 0;
+    while(plainCycles < 20000){
+        plainCycles += plain.Execute(std::min<long long>(1000, 20000 - plainCycles), *plainMem);
+    }
+
+    // then:
+    EXPECT_EQ(pacedCycles, plainCycles);
+    EXPECT_EQ(paced.PC, plain.PC);
+    EXPECT_EQ(memcmp(pacedMem->data, plainMem->data, M6502::Mem::MAX_MEM), 0);
+    EXPECT_GE(pacer.Stats.Elapsed, pacedCycles * 1000);
+    EXPECT_LE(pacer.Stats.Frequency(), pacer.Frequency);
+    EXPECT_EQ(pacer.Stats.Bursts + pacer.Stats.Resyncs, 20u);
+    EXPECT_GE(pacer.Stats.Jitter(0), 0);
+}
+
+TEST_F(M6502PacingTest, NothingRunsWithoutAFrequencyOrBursts)
+{
+    // given:
+    const M6502::Workload& workload = M6502::CorpusWorkloads[0];
+    workload.Setup(paced, *pacedMem);
+    M6502::u16 pc = paced.PC;
+
+    // when:
+    pacer.Frequency = 0;
+    long long withoutFrequency = pacer.Run(paced, *pacedMem, 20000);
+    pacer.Frequency = 1e6;
+    pacer.BurstCycles = 0;
+    long long withoutBursts = pacer.Run(paced, *pacedMem, 20000);
+
+    // then:
+    EXPECT_EQ(withoutFrequency, 0);
+    EXPECT_EQ(withoutBursts, 0);
+    EXPECT_EQ(paced.PC, pc);
+    EXPECT_EQ(pacer.Stats.Bursts, 0u);
+}
+
+TEST_F(M6502PacingTest, JitterIsAPercentileOfTheLateness)
+{
+    // given:
+    M6502::PacingStats stats;
+    for(int late = 100; late > 0; late--){
+        stats.Record(late);
+    }
+
+    // then:
+    EXPECT_EQ(stats.Jitter(0), 1);
+    EXPECT_EQ(stats.Jitter(50), 51);
+    EXPECT_EQ(stats.Jitter(99), 100);
+    EXPECT_EQ(stats.Jitter(100), 100);
+}
+
+TEST_F(M6502PacingTest, JitterIsWithinABucketOfTheLateness)
+{
+    // given:
+    M6502::PacingStats stats;
+    for(long long late = 1000; late <= 100000000; late *= 10){
+        stats.Record(late);
+        stats.Record(late + late / 3);
+    }
+
+    // then:
+    for(int i = 0; i < 12; i++){
+        long long jitter = stats.Jitter((i + 0.5) * 100 / 12);
+        long long late = 1000;
+        for(int j = 0; j < i / 2; j++){
+            late *= 10;
+        }
+        late += i % 2 ? late / 3 : 0;
+        EXPECT_GE(jitter, late);
+        EXPECT_LE(jitter, late + late / M6502::PacingStats::SUB_BUCKETS);
+    }
+    EXPECT_EQ(stats.Jitter(100), 133333333);
+}
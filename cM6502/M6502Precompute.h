@@ -0,0 +1,51 @@
+#ifndef M6502_PRECOMPUTE_H
+#define M6502_PRECOMPUTE_H
+#include "cM6502.h"
+
+// Runs 6502 code at compile time.
+//
+// Mem, BasicCPU<..., Mem> and Execute are constexpr, so an init routine
+// that only builds tables in RAM can run while compiling:
+//
+//   inline constexpr auto Tables = Precompute<CPU>(Init, 0x0200, 0x0200, 100000);
+//   static_assert(Tables.CPU.Halted);
+//   ...
+//   mem = Tables.Mem;
+//
+// The memory image it ends in is a constant in the binary, copying it is
+// all it takes at startup. The routine has to stop with JAM (or STP) within
+// the cycle budget, the CPU state says whether it did. Compilers limit
+// constant evaluation, see -fconstexpr-ops-limit and -fconstexpr-loop-limit
+// (GCC) or -fconstexpr-steps (Clang) for longer routines.
+
+namespace M6502
+{
+    template<typename CPUType> struct Precomputed;
+}
+
+template<typename CPUType>
+struct M6502::Precomputed{
+    CPUType CPU;
+    typename CPUType::MemoryType Mem;
+};
+
+namespace M6502
+{
+    // Resets, loads image at load and runs from entry until the CPU halts or
+    // cycles are used up
+    template<typename CPUType = CPU, u32 N>
+    constexpr Precomputed<CPUType> Precompute(const u8 (&image)[N], u16 load, u16 entry, int cycles)
+    {
+        Precomputed<CPUType> result;
+        result.CPU.Reset(result.Mem);
+        for(u32 i = 0; i < N; i++){
+            result.Mem[load + i] = image[i];
+        }
+        result.CPU.PC = entry;
+        while(!result.CPU.Halted && cycles > 0){
+            cycles -= result.CPU.Execute(cycles, result.Mem);
+        }
+        return result;
+    }
+}
+#endif
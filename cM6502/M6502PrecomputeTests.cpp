@@ -0,0 +1,97 @@
+#include <cstring>
+#include <memory>
+#include "gtest/gtest.h"
+#include "M6502Precompute.h"
+
+namespace
+{
+    // squares of 0-255, low bytes to $1000, high bytes to $1100
+    constexpr M6502::u8 SquaresInit[] = {
+        0xA9, 0x00,         // 0200 LDA #$00
+        0x85, 0x10,         // 0202 STA $10
+        0x85, 0x11,         // 0204 STA $11
+        0x85, 0x13,         // 0206 STA $13
+        0xA9, 0x01,         // 0208 LDA #$01
+        0x85, 0x12,         // 020A STA $12
+        0xAA,               // 020C TAX
+        0xCA,               // 020D DEX
+        // loop
+        0xA5, 0x10,         // 020E LDA $10
+        0x9D, 0x00, 0x10,   // 0210 STA $1000,X
+        0xA5, 0x11,         // 0213 LDA $11
+        0x9D, 0x00, 0x11,   // 0215 STA $1100,X
+        0x18,               // 0218 CLC
+        0xA5, 0x10,         // 0219 LDA $10
+        0x65, 0x12,         // 021B ADC $12
+        0x85, 0x10,         // 021D STA $10
+        0xA5, 0x11,         // 021F LDA $11
+        0x65, 0x13,         // 0221 ADC $13
+        0x85, 0x11,         // 0223 STA $11
+        0x18,               // 0225 CLC
+        0xA5, 0x12,         // 0226 LDA $12
+        0x69, 0x02,         // 0228 ADC #$02
+        0x85, 0x12,         // 022A STA $12
+        0xA5, 0x13,         // 022C LDA $13
+        0x69, 0x00,         // 022E ADC #$00
+        0x85, 0x13,         // 0230 STA $13
+        0xE8,               // 0232 INX
+        0xD0, 0xD9,         // 0233 BNE $020E
+        0x02,               // 0235 JAM
+    };
+
+    constexpr auto Squares = M6502::Precompute<M6502::CPU>(SquaresInit, 0x0200, 0x0200, 100000);
+    static_assert(Squares.CPU.Halted, "the init routine ends in JAM");
+    static_assert(Squares.Mem[0x1000 + 200] == (200 * 200 & 0xFF) && Squares.Mem[0x1100 + 200] == 200 * 200 >> 8,
+        "the table is built at compile time");
+
+    constexpr M6502::u8 UnstableOpcode[] = {0xA9, 0x01, 0x8B, 0x00};
+    constexpr auto Unhandled = M6502::Precompute<M6502::CPU>(UnstableOpcode, 0x0200, 0x0200, 100);
+    static_assert(Unhandled.CPU.Halted && Unhandled.CPU.PC == 0x0202 && Unhandled.CPU.A == 1,
+        "an unhandled opcode halts on the opcode");
+}
+
+class M6502PrecomputeTest : public testing::Test
+{
+public:
+    std::unique_ptr<M6502::Mem> mem{new M6502::Mem};
+    M6502::CPU cpu;
+};
+
+TEST_F(M6502PrecomputeTest, CompileTimeImageMatchesExecutionAtRunTime)
+{
+    // given:
+    cpu.Reset(*mem);
+    memcpy(mem->data + 0x0200, SquaresInit, sizeof(SquaresInit));
+    cpu.PC = 0x0200;
+
+    // when:
+    cpu.Execute(100000, *mem);
+
+    // then:
+    EXPECT_TRUE(cpu.Halted);
+    EXPECT_EQ(cpu.PC, Squares.CPU.PC);
+    EXPECT_EQ(cpu.GetStatus(), Squares.CPU.GetStatus());
+    EXPECT_EQ(memcmp(mem->data, Squares.Mem.data, M6502::Mem::MAX_MEM), 0);
+}
+
+TEST_F(M6502PrecomputeTest, CompileTimeImageIsTheBaselineToStartFrom)
+{
+    // when:
+    *mem = Squares.Mem;
+
+    // then:
+    for(int i = 0; i < 256; i++){
+        EXPECT_EQ((*mem)[0x1000 + i] | (*mem)[0x1100 + i] << 8, i * i);
+    }
+}
+
+TEST_F(M6502PrecomputeTest, CMOSRunsAtCompileTime)
+{
+    // given:
+    static constexpr M6502::u8 program[] = {0xA9, 0x41, 0x1A, 0x85, 0x10, 0xDB};  // LDA #$41, INC A, STA $10, STP
+    static constexpr auto cmos = M6502::Precompute<M6502::CPU65C02>(program, 0x0200, 0x0200, 100);
+
+    // then:
+    static_assert(cmos.CPU.Halted && cmos.Mem[0x10] == 0x42, "INC A and STP are 65C02 opcodes");
+    EXPECT_EQ(cmos.Mem[0x10], 0x42);
+}
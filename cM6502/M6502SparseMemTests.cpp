@@ -0,0 +1,88 @@
+#include "gtest/gtest.h"
+#include "cM6502.h"
+
+class M6502SparseMemTest : public testing::Test
+{
+public:
+    M6502::SparseMem mem;
+    M6502::BasicCPU<M6502::NMOS6502, M6502::SparseMem> cpu;
+    virtual void SetUp()
+    {
+        cpu.Reset(mem);
+    }
+};
+
+TEST_F(M6502SparseMemTest, UnwrittenMemoryReadsZeroWithoutAllocating)
+{
+    // given:
+    const M6502::SparseMem& view = mem;
+
+    // then:
+    EXPECT_EQ(view[0x1234], 0);
+    EXPECT_EQ(view[0xFFFF], 0);
+    EXPECT_EQ(mem.AllocatedPages(), 0u);
+}
+
+TEST_F(M6502SparseMemTest, WritingAllocatesOnlyThatPage)
+{
+    // given:
+    mem[0x4480] = 0x37;
+    mem[0x44FF] = 0x38;
+
+    // then:
+    const M6502::SparseMem& view = mem;
+    EXPECT_EQ(view[0x4480], 0x37);
+    EXPECT_EQ(view[0x44FF], 0x38);
+    EXPECT_EQ(view[0x4500], 0);
+    EXPECT_EQ(mem.AllocatedPages(), 1u);
+}
+
+TEST_F(M6502SparseMemTest, InitializeReleasesThePages)
+{
+    // given:
+    mem[0x0200] = 0x01;
+    mem[0x8000] = 0x02;
+
+    //when:
+    mem.Initialize();
+
+    // then:
+    const M6502::SparseMem& view = mem;
+    EXPECT_EQ(view[0x0200], 0);
+    EXPECT_EQ(mem.AllocatedPages(), 0u);
+}
+
+TEST_F(M6502SparseMemTest, CopiesDoNotSharePages)
+{
+    // given:
+    mem[0x0200] = 0x01;
+
+    //when:
+    M6502::SparseMem copy = mem;
+    copy[0x0200] = 0x02;
+
+    // then:
+    const M6502::SparseMem& view = mem;
+    EXPECT_EQ(view[0x0200], 0x01);
+    EXPECT_EQ(copy.AllocatedPages(), 1u);
+}
+
+TEST_F(M6502SparseMemTest, CPUReadsOnlyAllocateTheProgramPage)
+{
+    // given:
+    cpu.PC = 0x0200;
+    mem[0x0200] = M6502::CPU::INS_LDA_ABS;
+    mem[0x0201] = 0x80;
+    mem[0x0202] = 0x44;
+    mem[0x0203] = M6502::CPU::INS_STA_ZP;
+    mem[0x0204] = 0x10;
+
+    //when:
+    int cyclesUsed = cpu.Execute(7, mem);
+
+    // then:
+    EXPECT_EQ(cyclesUsed, 7);
+    EXPECT_EQ(cpu.A, 0);
+    EXPECT_TRUE(cpu.Z);
+    EXPECT_EQ(mem.AllocatedPages(), 2u);
+}
@@ -0,0 +1,185 @@
+#ifndef M6502_SPECULATE_H
+#define M6502_SPECULATE_H
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "cM6502.h"
+
+// Time-parallel speculative execution.
+//
+// A run is cut into segments of SegmentCycles, each executed with one
+// Execute call, so its result only depends on the state it starts in.
+// Worker threads run every segment at once, each from a predicted start
+// state: the checkpoints Record took in an earlier run with the same
+// inputs, or states from any other guess at where the run will be.
+//
+// The calling thread then goes through the segments in order. When the
+// state the run actually reached equals the prediction for the next
+// segment, the worker's result is committed, else the segment runs again
+// from the real state. Either way the result is that of running the
+// segments one after the other, wrong predictions only cost time. Workers
+// keep within Threads segments of the one being validated, so only that
+// many results are held at once.
+
+namespace M6502
+{
+    using u64 = unsigned long long;
+    template<typename CPUType = CPU> struct Checkpoint;
+    template<typename CPUType = CPU> struct Speculator;
+}
+
+// CPU and memory, Mem only
+template<typename CPUType>
+struct M6502::Checkpoint{
+    CPUType CPU;
+    Mem Memory;
+    int Cycles = 0;
+
+    void Save(const CPUType& cpu, const Mem& mem)
+    {
+        CPU = cpu;
+        memcpy(Memory.data, mem.data, Mem::MAX_MEM);
+    }
+
+    void Restore(CPUType& cpu, Mem& mem) const
+    {
+        cpu = CPU;
+        memcpy(mem.data, Memory.data, Mem::MAX_MEM);
+    }
+
+    bool Matches(const CPUType& cpu, const Mem& mem) const
+    {
+        return CPU.PC == cpu.PC && CPU.SP == cpu.SP && CPU.A == cpu.A && CPU.X == cpu.X && CPU.Y == cpu.Y &&
+               CPU.GetStatus() == cpu.GetStatus() && CPU.Halted == cpu.Halted && CPU.Waiting == cpu.Waiting &&
+               memcmp(Memory.data, mem.data, Mem::MAX_MEM) == 0;
+    }
+};
+
+template<typename CPUType>
+struct M6502::Speculator{
+    using State = Checkpoint<CPUType>;
+    using States = std::vector<std::unique_ptr<State>>;
+
+    int SegmentCycles = 1000000;
+    int Threads = std::max(1u, std::thread::hardware_concurrency());
+
+    // of the last Run
+    u64 Segments = 0;
+    u64 Committed = 0;
+    u64 Mispredicted = 0;
+    // segments that had no prediction
+    u64 Unpredicted = 0;
+
+    double MispredictionRate() const
+    {
+        return Segments > 1 ? double(Mispredicted + Unpredicted) / (Segments - 1) : 0;
+    }
+
+    // Runs the segments one after the other, returns the state each one
+    // starts in as the predictions for a later Run
+    States Record(CPUType& cpu, Mem& mem, long long cycles)
+    {
+        States starts;
+        for(size_t i = 0; i < Count(cycles); i++){
+            starts.emplace_back(new State);
+            starts.back()->Save(cpu, mem);
+            cpu.Execute(SegmentCycles, mem);
+        }
+        return starts;
+    }
+
+    // segments that make up cycles
+    size_t Count(long long cycles) const
+    {
+        return static_cast<size_t>((cycles + SegmentCycles - 1) / SegmentCycles);
+    }
+
+    // Runs the segments of cycles from cpu and mem, segment i speculatively
+    // from predicted[i], returns the cycles used. Each prediction is
+    // released once its segment is settled.
+    long long Run(CPUType& cpu, Mem& mem, long long cycles, States& predicted)
+    {
+        enum : int { PENDING, DONE, ABANDONED };
+        size_t count = Count(cycles);
+        size_t threads = static_cast<size_t>(std::max(1, Threads));
+        Segments = count;
+        Committed = Mispredicted = Unpredicted = 0;
+        predicted.resize(std::max(predicted.size(), count));
+
+        State first;
+        first.Save(cpu, mem);
+        States results(count);
+        // a worker leaves an abandoned segment's result and prediction to
+        // itself, the validator a done one's
+        std::unique_ptr<std::atomic<int>[]> status(new std::atomic<int>[count]);
+        for(size_t i = 0; i < count; i++){
+            status[i] = PENDING;
+        }
+        std::atomic<size_t> next{0};
+        // the segment the validator is on, workers stay within threads of it
+        std::atomic<size_t> validating{0};
+        std::atomic<bool> stop{false};
+        auto work = [&](){
+            for(size_t i; !stop && (i = next++) < count;){
+                while(!stop && i >= validating + threads){
+                    std::this_thread::yield();
+                }
+                const State* start = i == 0 ? &first : predicted[i].get();
+                std::unique_ptr<State> result;
+                if(start && status[i] == PENDING){
+                    result.reset(new State);
+                    result->CPU = start->CPU;
+                    memcpy(result->Memory.data, start->Memory.data, Mem::MAX_MEM);
+                    result->Cycles = result->CPU.Execute(SegmentCycles, result->Memory);
+                }
+                results[i] = std::move(result);
+                int pending = PENDING;
+                if(!status[i].compare_exchange_strong(pending, DONE)){
+                    results[i].reset();
+                    predicted[i].reset();
+                }
+            }
+        };
+        std::vector<std::thread> workers;
+        for(size_t i = 0; i < threads; i++){
+            workers.emplace_back(work);
+        }
+
+        long long used = 0;
+        for(size_t i = 0; i < count; i++){
+            validating = i;
+            bool predictedHere = i == 0 || predicted[i];
+            bool valid = i == 0 || (predictedHere && predicted[i]->Matches(cpu, mem));
+            if(valid){
+                while(status[i] != DONE){
+                    std::this_thread::yield();
+                }
+                results[i]->Restore(cpu, mem);
+                used += results[i]->Cycles;
+                results[i].reset();
+                predicted[i].reset();
+                Committed++;
+            }else{
+                if(status[i].exchange(ABANDONED) == DONE){
+                    results[i].reset();
+                    predicted[i].reset();
+                }
+                used += cpu.Execute(SegmentCycles, mem);
+                (predictedHere ? Mispredicted : Unpredicted)++;
+            }
+        }
+        stop = true;
+        for(std::thread& worker : workers){
+            worker.join();
+        }
+        // the abandoned segments no worker got to
+        for(size_t i = 0; i < count; i++){
+            predicted[i].reset();
+        }
+        return used;
+    }
+};
+#endif
@@ -0,0 +1,116 @@
+#include <cstring>
+#include <memory>
+#include "gtest/gtest.h"
+#include "M6502Speculate.h"
+#include "M6502Workloads.h"
+
+class M6502SpeculateTest : public testing::Test
+{
+public:
+    static constexpr long long CYCLES = 2000000;
+    const M6502::Workload& workload = M6502::BenchmarkWorkloads[0];
+    std::unique_ptr<M6502::Mem> mem{new M6502::Mem};
+    std::unique_ptr<M6502::Mem> sequentialMem{new M6502::Mem};
+    M6502::CPU cpu;
+    M6502::CPU sequential;
+    M6502::Speculator<> speculator;
+
+    virtual void SetUp()
+    {
+        speculator.SegmentCycles = 100000;
+        speculator.Threads = 2;
+        workload.Setup(cpu, *mem);
+        workload.Setup(sequential, *sequentialMem);
+    }
+
+    // the same segments, one after the other
+    long long RunSequentially()
+    {
+        long long used = 0;
+        for(size_t i = 0; i < speculator.Count(CYCLES); i++){
+            used += sequential.Execute(speculator.SegmentCycles, *sequentialMem);
+        }
+        return used;
+    }
+
+    M6502::Speculator<>::States RecordWith(M6502::u16 address, M6502::u8 value)
+    {
+        M6502::CPU recording;
+        std::unique_ptr<M6502::Mem> recordingMem(new M6502::Mem);
+        workload.Setup(recording, *recordingMem);
+        (*recordingMem)[address] = value;
+        return speculator.Record(recording, *recordingMem, CYCLES);
+    }
+
+    void ExpectSameAsSequential(long long used)
+    {
+        EXPECT_EQ(used, RunSequentially());
+        EXPECT_EQ(cpu.PC, sequential.PC);
+        EXPECT_EQ(cpu.A, sequential.A);
+        EXPECT_EQ(cpu.GetStatus(), sequential.GetStatus());
+        EXPECT_EQ(memcmp(mem->data, sequentialMem->data, M6502::Mem::MAX_MEM), 0);
+    }
+};
+
+TEST_F(M6502SpeculateTest, RecordedPredictionsAreAllCommitted)
+{
+    // given:
+    M6502::Speculator<>::States predicted = RecordWith(0x0100, 0);
+
+    // when:
+    long long used = speculator.Run(cpu, *mem, CYCLES, predicted);
+
+    // then:
+    ExpectSameAsSequential(used);
+    EXPECT_EQ(speculator.Segments, 20u);
+    EXPECT_EQ(speculator.Committed, 20u);
+    EXPECT_EQ(speculator.MispredictionRate(), 0);
+}
+
+TEST_F(M6502SpeculateTest, WrongPredictionsAreExecutedAgain)
+{
+    // given: a recording with a byte the program never touches set
+    M6502::Speculator<>::States predicted = RecordWith(0x4000, 1);
+
+    // when:
+    long long used = speculator.Run(cpu, *mem, CYCLES, predicted);
+
+    // then:
+    ExpectSameAsSequential(used);
+    EXPECT_EQ(speculator.Committed, 1u);
+    EXPECT_EQ(speculator.Mispredicted, 19u);
+    EXPECT_EQ(speculator.MispredictionRate(), 1);
+    for(const std::unique_ptr<M6502::Checkpoint<>>& state : predicted){
+        EXPECT_FALSE(state);
+    }
+}
+
+TEST_F(M6502SpeculateTest, SegmentsWithoutPredictionRunInOrder)
+{
+    // given:
+    M6502::Speculator<>::States predicted = RecordWith(0x0100, 0);
+    predicted.resize(10);
+    predicted[5].reset();
+
+    // when:
+    long long used = speculator.Run(cpu, *mem, CYCLES, predicted);
+
+    // then:
+    ExpectSameAsSequential(used);
+    EXPECT_EQ(speculator.Unpredicted, 11u);
+    EXPECT_EQ(speculator.Committed, 9u);
+}
+
+TEST_F(M6502SpeculateTest, NoThreadsStillRunsOneWorker)
+{
+    // given:
+    M6502::Speculator<>::States predicted = RecordWith(0x0100, 0);
+    speculator.Threads = 0;
+
+    // when:
+    long long used = speculator.Run(cpu, *mem, CYCLES, predicted);
+
+    // then:
+    ExpectSameAsSequential(used);
+    EXPECT_EQ(speculator.Committed, 20u);
+}
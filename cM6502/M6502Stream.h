@@ -0,0 +1,326 @@
+#ifndef M6502_STREAM_H
+#define M6502_STREAM_H
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "cM6502.h"
+#ifdef __unix__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Streaming I/O ports for guest programs.
+//
+// StreamMem is flat memory with three device registers at addresses given
+// by StreamPorts:
+//
+//   Read    each read returns the next input byte, 0 after the end
+//   Write   each write appends a byte to the output
+//   Status  bit 7 set while input is left, bit 6 set while the output has
+//           room, so BIT Status / BPL and BVC test them
+//
+// Input is a file mapped into memory (or any buffer the caller keeps
+// alive), the Read port reads straight from it. Output goes into a ring
+// that a background thread writes to the output file. A write to a full
+// ring waits for that thread, guests that must never wait poll bit 6.
+// Without an open output file written bytes are dropped.
+//
+// The pages holding the ports are I/O pages, the rest of them is RAM.
+
+namespace M6502
+{
+    using u64 = unsigned long long;
+    struct StreamPorts;
+    struct OutputRing;
+    struct StreamMem;
+    using StreamCPU = BasicCPU<NMOS6502, StreamMem>;
+}
+
+struct M6502::StreamPorts{
+    u16 Read = 0xF000;
+    u16 Write = 0xF001;
+    u16 Status = 0xF002;
+
+    static constexpr u8 INPUT_READY = 0x80;
+    static constexpr u8 OUTPUT_READY = 0x40;
+};
+
+// single producer (the CPU), single consumer (the flusher thread)
+struct M6502::OutputRing{
+    static constexpr size_t CAPACITY = 1 << 20;
+
+    // writes that found the ring full
+    std::atomic<u64> Stalls{0};
+
+    OutputRing() : buffer(new u8[CAPACITY])
+    {
+    }
+
+    OutputRing(const OutputRing&) = delete;
+    OutputRing& operator=(const OutputRing&) = delete;
+
+    ~OutputRing()
+    {
+        Close();
+    }
+
+    bool Open(const char* path)
+    {
+        Close();
+        file = fopen(path, "wb");
+        if(!file){
+            return false;
+        }
+        stop = false;
+        flusher = std::thread(&OutputRing::Flush, this);
+        return true;
+    }
+
+    // writes out what is left, waits for the thread
+    void Close()
+    {
+        if(!file){
+            return;
+        }
+        stop = true;
+        flusher.join();
+        fclose(file);
+        file = nullptr;
+    }
+
+    bool IsOpen() const
+    {
+        return file != nullptr;
+    }
+
+    bool Room() const
+    {
+        return tail.load(std::memory_order_relaxed) - head.load(std::memory_order_acquire) < CAPACITY;
+    }
+
+    void Put(u8 value)
+    {
+        if(!file){
+            return;
+        }
+        if(!Room()){
+            Stalls++;
+            while(!Room()){
+                std::this_thread::yield();
+            }
+        }
+        size_t at = tail.load(std::memory_order_relaxed);
+        buffer[at & (CAPACITY - 1)] = value;
+        tail.store(at + 1, std::memory_order_release);
+    }
+
+private:
+    std::unique_ptr<u8[]> buffer;
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+    std::atomic<bool> stop{false};
+    FILE* file = nullptr;
+    std::thread flusher;
+
+    // writes everything in the ring, false when it was empty
+    bool WriteOut()
+    {
+        size_t from = head.load(std::memory_order_relaxed);
+        size_t to = tail.load(std::memory_order_acquire);
+        if(from == to){
+            return false;
+        }
+        while(from != to){
+            size_t offset = from & (CAPACITY - 1);
+            size_t length = std::min(to - from, CAPACITY - offset);
+            fwrite(buffer.get() + offset, 1, length, file);
+            from += length;
+        }
+        head.store(to, std::memory_order_release);
+        return true;
+    }
+
+    void Flush()
+    {
+        while(!stop.load()){
+            if(!WriteOut()){
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        WriteOut();
+        fflush(file);
+    }
+};
+
+struct M6502::StreamMem{
+    static constexpr u32 MAX_MEM = 1024 * 64;
+
+    const StreamPorts Ports;
+    OutputRing Output;
+
+    explicit StreamMem(const StreamPorts& ports = StreamPorts()) : Ports(ports), data(new u8[MAX_MEM]())
+    {
+        io[Ports.Read >> 8] = io[Ports.Write >> 8] = io[Ports.Status >> 8] = true;
+    }
+
+    StreamMem(const StreamMem&) = delete;
+    StreamMem& operator=(const StreamMem&) = delete;
+
+    ~StreamMem()
+    {
+        Unmap();
+    }
+
+    // reads from input, which has to stay alive while it is used
+    void SetInput(const u8* input, size_t size)
+    {
+        Unmap();
+        Use(input, size);
+    }
+
+    bool OpenInput(const char* path)
+    {
+        Unmap();
+#ifdef __unix__
+        int fd = open(path, O_RDONLY);
+        if(fd < 0){
+            return false;
+        }
+        struct stat info;
+        if(fstat(fd, &info) != 0){
+            close(fd);
+            return false;
+        }
+        size_t size = info.st_size;
+        void* mapping = size ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : nullptr;
+        close(fd);
+        if(mapping == MAP_FAILED){
+            return false;
+        }
+        if(mapping){
+            madvise(mapping, size, MADV_SEQUENTIAL);
+        }
+        mapped = mapping;
+        mappedSize = size;
+        Use(static_cast<const u8*>(mapping), size);
+#else
+        FILE* file = fopen(path, "rb");
+        if(!file){
+            return false;
+        }
+        copied.clear();
+        u8 chunk[4096];
+        for(size_t read; (read = fread(chunk, 1, sizeof(chunk), file)) > 0;){
+            copied.insert(copied.end(), chunk, chunk + read);
+        }
+        fclose(file);
+        Use(copied.data(), copied.size());
+#endif
+        return true;
+    }
+
+    bool OpenOutput(const char* path)
+    {
+        return Output.Open(path);
+    }
+
+    // input bytes the guest has read
+    size_t InputRead() const
+    {
+        return inputAt;
+    }
+
+    struct Byte{
+        StreamMem& mem;
+        u32 address;
+
+        Byte& operator=(u8 value)
+        {
+            if(mem.io[address >> 8] && address == mem.Ports.Write){
+                mem.Output.Put(value);
+            }else{
+                mem.data[address] = value;
+            }
+            return *this;
+        }
+
+        operator u8() const
+        {
+            return static_cast<const StreamMem&>(mem)[address];
+        }
+    };
+
+    void Initialize()
+    {
+        std::fill(data.get(), data.get() + MAX_MEM, 0);
+    }
+
+    // Read one Byte, reading the Read port consumes it
+    u8 operator[](u32 address) const
+    {
+        if(io[address >> 8]){
+            if(address == Ports.Read){
+                return inputAt < inputSize ? input[inputAt++] : 0;
+            }
+            if(address == Ports.Status){
+                return (inputAt < inputSize ? StreamPorts::INPUT_READY : 0) |
+                       (Output.Room() ? StreamPorts::OUTPUT_READY : 0);
+            }
+        }
+        return data[address];
+    }
+
+    // Write one Byte
+    Byte operator[](u32 address)
+    {
+        return {*this, address};
+    }
+
+    void WriteWord(u16 value, u16 address)
+    {
+        (*this)[address] = value & 0xFF;
+        (*this)[static_cast<u16>(address + 1)] = (value >> 8);
+    }
+
+    bool IsIOPage(u8 page) const
+    {
+        return io[page];
+    }
+
+private:
+    std::unique_ptr<u8[]> data;
+    bool io[256] = {};
+    const u8* input = nullptr;
+    size_t inputSize = 0;
+    mutable size_t inputAt = 0;
+    void* mapped = nullptr;
+    size_t mappedSize = 0;
+    std::vector<u8> copied;
+
+    void Use(const u8* input, size_t size)
+    {
+        this->input = input;
+        inputSize = size;
+        inputAt = 0;
+    }
+
+    void Unmap()
+    {
+#ifdef __unix__
+        if(mapped){
+            munmap(mapped, mappedSize);
+        }
+#endif
+        mapped = nullptr;
+        mappedSize = 0;
+        input = nullptr;
+        inputSize = 0;
+    }
+};
+#endif
@@ -0,0 +1,103 @@
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+#include "M6502Stream.h"
+
+namespace
+{
+    // copies the input to the output with bit 5 of every byte flipped
+    constexpr M6502::u8 FlipProgram[] = {
+        // loop
+        0x2C, 0x02, 0xF0,   // 0200 BIT $F002
+        0x10, 0x0B,         // 0203 BPL $0210
+        0xAD, 0x00, 0xF0,   // 0205 LDA $F000
+        0x49, 0x20,         // 0208 EOR #$20
+        0x8D, 0x01, 0xF0,   // 020A STA $F001
+        0x4C, 0x00, 0x02,   // 020D JMP $0200
+        // done
+        0x02,               // 0210 JAM
+    };
+}
+
+class M6502StreamTest : public testing::Test
+{
+public:
+    M6502::StreamCPU cpu;
+
+    void Load(M6502::StreamMem& mem)
+    {
+        cpu.Reset(mem);
+        for(M6502::u32 i = 0; i < sizeof(FlipProgram); i++){
+            mem[0x0200 + i] = FlipProgram[i];
+        }
+        cpu.PC = 0x0200;
+    }
+};
+
+TEST_F(M6502StreamTest, GuestStreamsAnInputFileToAnOutputFile)
+{
+    // given:
+    std::string inputPath = testing::TempDir() + "m6502_stream_in";
+    std::string outputPath = testing::TempDir() + "m6502_stream_out";
+    std::vector<char> input(3 << 19);
+    for(size_t i = 0; i < input.size(); i++){
+        input[i] = static_cast<char>(i * 131 + (i >> 9));
+    }
+    std::ofstream(inputPath, std::ios::binary).write(input.data(), input.size());
+    std::unique_ptr<M6502::StreamMem> mem(new M6502::StreamMem);
+    ASSERT_TRUE(mem->OpenInput(inputPath.c_str()));
+    ASSERT_TRUE(mem->OpenOutput(outputPath.c_str()));
+    Load(*mem);
+
+    // when:
+    while(!cpu.Halted){
+        cpu.Execute(1000000, *mem);
+    }
+    mem->Output.Close();
+
+    // then:
+    EXPECT_EQ(mem->InputRead(), input.size());
+    std::ifstream file(outputPath, std::ios::binary);
+    std::vector<char> output((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    ASSERT_EQ(output.size(), input.size());
+    bool flipped = true;
+    for(size_t i = 0; i < input.size(); i++){
+        flipped &= output[i] == (input[i] ^ 0x20);
+    }
+    EXPECT_TRUE(flipped);
+    remove(inputPath.c_str());
+    remove(outputPath.c_str());
+}
+
+TEST_F(M6502StreamTest, PortsAreWhereTheyAreConfigured)
+{
+    // given:
+    M6502::StreamPorts ports;
+    ports.Read = 0xD010;
+    ports.Write = 0xD011;
+    ports.Status = 0xC000;
+    std::unique_ptr<M6502::StreamMem> mem(new M6502::StreamMem(ports));
+    const M6502::u8 input[] = {7, 8};
+    mem->SetInput(input, sizeof(input));
+    const M6502::StreamMem& bus = *mem;
+
+    // when:
+    (*mem)[0xD012] = 0x55;
+    (*mem)[0xF000] = 0x66;
+
+    // then:
+    EXPECT_TRUE(mem->IsIOPage(0xD0));
+    EXPECT_TRUE(mem->IsIOPage(0xC0));
+    EXPECT_FALSE(mem->IsIOPage(0xF0));
+    EXPECT_EQ(bus[0xD012], 0x55);
+    EXPECT_EQ(bus[0xF000], 0x66);
+    EXPECT_EQ(bus[0xC000], M6502::StreamPorts::INPUT_READY | M6502::StreamPorts::OUTPUT_READY);
+    EXPECT_EQ(bus[0xD010], 7);
+    EXPECT_EQ(bus[0xD010], 8);
+    EXPECT_EQ(bus[0xC000], M6502::StreamPorts::OUTPUT_READY);
+    EXPECT_EQ(bus[0xD010], 0);
+    EXPECT_EQ(mem->InputRead(), 2u);
+}
@@ -0,0 +1,231 @@
+#ifndef M6502_SYSTEM_H
+#define M6502_SYSTEM_H
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include "cM6502.h"
+
+// Several CPUs sharing RAM on one bus.
+//
+// Every CPU has its own 64KB behind a BusMem, with the pages of the shared
+// region mapped to the same storage for all of them. Mailbox registers
+// between the CPUs are plain bytes in the shared region.
+//
+// Run interleaves the CPUs in bursts of Burst cycles, one after the other.
+// BusMem notes when a CPU touches a shared page. Once two CPUs touched
+// shared pages less than Linger cycles apart the system runs one
+// instruction at a time, always on the CPU furthest behind, until Linger
+// cycles pass without that happening again. A burst of 1 (or less) always
+// runs instruction by instruction. The burst in which the contention shows
+// up first still runs whole, that is the accuracy traded for throughput.
+// BusMem only notes that a burst touched a shared page, not when, so the
+// access counts as made at the end of the burst. Instruction fetches from a
+// shared page count as touching it like any other read.
+
+namespace M6502
+{
+    using u64 = unsigned long long;
+    struct BusMem;
+    using BusCPU = BasicCPU<NMOS6502, BusMem>;
+    using BusCPU65C02 = BasicCPU<WDC65C02, BusMem>;
+    template<typename CPUType = BusCPU> struct System;
+}
+
+struct M6502::BusMem{
+    static constexpr u32 MAX_MEM = 1024 * 64;
+    static constexpr u32 PAGE_SIZE = 256;
+    static constexpr u32 NUM_PAGES = MAX_MEM / PAGE_SIZE;
+
+    u8* pages[NUM_PAGES];
+    bool shared[NUM_PAGES] = {};
+    // set by any access to a shared page, cleared by the system
+    mutable bool TouchedShared = false;
+
+    BusMem() : own(new u8[MAX_MEM]())
+    {
+        for(u32 i = 0; i < NUM_PAGES; i++){
+            pages[i] = own.get() + i * PAGE_SIZE;
+        }
+    }
+
+    BusMem(const BusMem&) = delete;
+    BusMem& operator=(const BusMem&) = delete;
+
+    void Share(u8 page, u8* memory)
+    {
+        pages[page] = memory;
+        shared[page] = true;
+    }
+
+    // clears the private pages only, the shared ones belong to the system
+    void Initialize()
+    {
+        for(u32 i = 0; i < NUM_PAGES; i++){
+            if(!shared[i]){
+                std::fill(pages[i], pages[i] + PAGE_SIZE, 0);
+            }
+        }
+    }
+
+    // Read one Byte
+    u8 operator[](u32 address) const
+    {
+        TouchedShared |= shared[address >> 8];
+        return pages[address >> 8][address & 0xFF];
+    }
+
+    // Write one Byte
+    u8& operator[](u32 address)
+    {
+        TouchedShared |= shared[address >> 8];
+        return pages[address >> 8][address & 0xFF];
+    }
+
+    void WriteWord(u16 value, u16 address)
+    {
+        (*this)[address] = value & 0xFF;
+        (*this)[static_cast<u16>(address + 1)] = (value >> 8);
+    }
+
+    // other CPUs change shared pages behind this one's back
+    bool IsIOPage(u8 page) const
+    {
+        return shared[page];
+    }
+
+private:
+    std::unique_ptr<u8[]> own;
+};
+
+template<typename CPUType>
+struct M6502::System{
+    struct Node{
+        CPUType CPU;
+        BusMem Mem;
+        // cycles run so far
+        long long Cycles = 0;
+        // when it last touched a shared page, -1 for never
+        long long LastShared = -1;
+    };
+
+    std::vector<std::unique_ptr<Node>> Nodes;
+    int Burst = 1000;
+    long long Linger = 10000;
+
+    // all CPUs have run at least this far
+    long long Time = 0;
+    u64 Bursts = 0;
+    u64 Steps = 0;
+    u64 Contentions = 0;
+
+    // pages firstPage to lastPage are shared by all CPUs, added before or after
+    void Share(u8 firstPage, u8 lastPage)
+    {
+        for(u32 page = firstPage; page <= lastPage; page++){
+            if(!shared[page]){
+                shared[page].reset(new u8[BusMem::PAGE_SIZE]());
+            }
+            for(std::unique_ptr<Node>& node : Nodes){
+                node->Mem.Share(page, shared[page].get());
+            }
+        }
+    }
+
+    Node& Add()
+    {
+        Nodes.emplace_back(new Node);
+        Node& node = *Nodes.back();
+        for(u32 page = 0; page < BusMem::NUM_PAGES; page++){
+            if(shared[page]){
+                node.Mem.Share(page, shared[page].get());
+            }
+        }
+        node.Cycles = Time;
+        return node;
+    }
+
+    Node& operator[](size_t index)
+    {
+        return *Nodes[index];
+    }
+
+    // Runs every CPU for cycles, returns the cycles the system advanced
+    long long Run(long long cycles)
+    {
+        long long start = Time;
+        long long end = Time + cycles;
+        while(Time < end && !Nodes.empty()){
+            if(Burst <= 1 || Time < fineUntil){
+                Step(end);
+            }else{
+                RunBurst(std::min<long long>(Time + Burst, end));
+            }
+        }
+        return Time - start;
+    }
+
+private:
+    std::unique_ptr<u8[]> shared[BusMem::NUM_PAGES];
+    long long fineUntil = 0;
+
+    // notes a shared access of node at time, true when another CPU made one
+    // recently
+    bool Contended(Node& node, long long time)
+    {
+        node.LastShared = time;
+        for(std::unique_ptr<Node>& other : Nodes){
+            if(other.get() != &node && other->LastShared >= 0 && time - other->LastShared <= Linger){
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void RunBurst(long long until)
+    {
+        bool contended = false;
+        for(std::unique_ptr<Node>& node : Nodes){
+            node->Mem.TouchedShared = false;
+            while(node->Cycles < until && !node->CPU.Halted){
+                node->Cycles += node->CPU.Execute(static_cast<int>(until - node->Cycles), node->Mem);
+            }
+            // a halted CPU idles
+            node->Cycles = std::max(node->Cycles, until);
+            if(node->Mem.TouchedShared){
+                contended |= Contended(*node, until);
+            }
+        }
+        Time = until;
+        Bursts++;
+        if(contended){
+            fineUntil = Time + Linger;
+            Contentions++;
+        }
+    }
+
+    // one instruction on the CPU furthest behind, a halted one idles to end
+    void Step(long long end)
+    {
+        Node* behind = Nodes.front().get();
+        for(std::unique_ptr<Node>& node : Nodes){
+            if(node->Cycles < behind->Cycles){
+                behind = node.get();
+            }
+        }
+        behind->Mem.TouchedShared = false;
+        if(behind->CPU.Halted){
+            behind->Cycles = end;
+        }else{
+            behind->Cycles += behind->CPU.Execute(1, behind->Mem);
+        }
+        if(behind->Mem.TouchedShared && Contended(*behind, behind->Cycles)){
+            fineUntil = behind->Cycles + Linger;
+        }
+        Time = behind->Cycles;
+        for(std::unique_ptr<Node>& node : Nodes){
+            Time = std::min(Time, node->Cycles);
+        }
+        Steps++;
+    }
+};
+#endif
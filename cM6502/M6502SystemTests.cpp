@@ -0,0 +1,138 @@
+#include <memory>
+#include "gtest/gtest.h"
+#include "M6502System.h"
+
+namespace
+{
+    // sends 1, 2, 3... through $8000 and waits for each to come back on
+    // $8001, counts round trips at $10/$11
+    constexpr M6502::u8 PingProgram[] = {
+        0xA2, 0x00,         // 0200 LDX #$00
+        // loop
+        0xE8,               // 0202 INX
+        0x8E, 0x00, 0x80,   // 0203 STX $8000
+        // wait
+        0xEC, 0x01, 0x80,   // 0206 CPX $8001
+        0xD0, 0xFB,         // 0209 BNE $0206
+        0xE6, 0x10,         // 020B INC $10
+        0xD0, 0xF3,         // 020D BNE $0202
+        0xE6, 0x11,         // 020F INC $11
+        0x4C, 0x02, 0x02,   // 0211 JMP $0202
+    };
+
+    // copies $8000 to $8001 whenever they differ
+    constexpr M6502::u8 EchoProgram[] = {
+        // loop
+        0xAD, 0x00, 0x80,   // 0200 LDA $8000
+        0xCD, 0x01, 0x80,   // 0203 CMP $8001
+        0xF0, 0xF8,         // 0206 BEQ $0200
+        0x8D, 0x01, 0x80,   // 0208 STA $8001
+        0x4C, 0x00, 0x02,   // 020B JMP $0200
+    };
+
+    // counts at $10/$11 without touching the shared page
+    constexpr M6502::u8 CountProgram[] = {
+        // loop
+        0xE6, 0x10,         // 0200 INC $10
+        0xD0, 0xFC,         // 0202 BNE $0200
+        0xE6, 0x11,         // 0204 INC $11
+        0x4C, 0x00, 0x02,   // 0206 JMP $0200
+    };
+}
+
+class M6502SystemTest : public testing::Test
+{
+public:
+    M6502::System<> system;
+
+    virtual void SetUp()
+    {
+        system.Share(0x80, 0x80);
+    }
+
+    template<M6502::u32 N>
+    void Load(M6502::System<>::Node& node, const M6502::u8 (&program)[N])
+    {
+        node.CPU.Reset(node.Mem);
+        for(M6502::u32 i = 0; i < N; i++){
+            node.Mem[0x0200 + i] = program[i];
+        }
+        node.CPU.PC = 0x0200;
+    }
+
+    static int Counted(M6502::System<>::Node& node)
+    {
+        return node.Mem[0x10] | node.Mem[0x11] << 8;
+    }
+
+    int RoundTrips(int burst)
+    {
+        M6502::System<> system;
+        system.Share(0x80, 0x80);
+        system.Burst = burst;
+        Load(system.Add(), PingProgram);
+        Load(system.Add(), EchoProgram);
+        system.Run(100000);
+        return Counted(system[0]);
+    }
+};
+
+TEST_F(M6502SystemTest, SharedPagesAreTheSameMemoryForAllCPUs)
+{
+    // given:
+    M6502::System<>::Node& first = system.Add();
+    M6502::System<>::Node& second = system.Add();
+
+    // when:
+    first.Mem[0x8005] = 0x42;
+    first.Mem[0x1005] = 0x43;
+    second.CPU.Reset(second.Mem);
+    M6502::System<>::Node& late = system.Add();
+
+    // then:
+    EXPECT_EQ(second.Mem[0x8005], 0x42);
+    EXPECT_EQ(late.Mem[0x8005], 0x42);
+    EXPECT_EQ(second.Mem[0x1005], 0);
+    EXPECT_TRUE(second.Mem.IsIOPage(0x80));
+    EXPECT_FALSE(second.Mem.IsIOPage(0x10));
+}
+
+TEST_F(M6502SystemTest, CPUsThatDoNotShareRunInWholeBursts)
+{
+    // given:
+    Load(system.Add(), CountProgram);
+    Load(system.Add(), CountProgram);
+    M6502::Mem mem;
+    M6502::CPU alone;
+    alone.Reset(mem);
+    for(size_t i = 0; i < sizeof(CountProgram); i++){
+        mem[0x0200 + i] = CountProgram[i];
+    }
+    alone.PC = 0x0200;
+
+    // when:
+    system.Run(100000);
+    long long cycles = 0;
+    while(cycles < 100000){
+        cycles += alone.Execute(std::min<long long>(1000, 100000 - cycles), mem);
+    }
+
+    // then:
+    EXPECT_EQ(system.Time, 100000);
+    EXPECT_EQ(system.Bursts, 100u);
+    EXPECT_EQ(system.Steps, 0u);
+    EXPECT_EQ(system.Contentions, 0u);
+    EXPECT_EQ(Counted(system[0]), mem[0x10] | mem[0x11] << 8);
+    EXPECT_EQ(Counted(system[1]), Counted(system[0]));
+}
+
+TEST_F(M6502SystemTest, MailboxTrafficSwitchesToInstructionInterleaving)
+{
+    // when:
+    int interleaved = RoundTrips(1);
+    int adaptive = RoundTrips(1000);
+
+    // then:
+    EXPECT_GT(interleaved, 1000);
+    EXPECT_GT(adaptive, interleaved * 9 / 10);
+}
@@ -0,0 +1,367 @@
+#include "gtest/gtest.h"
+#include "cM6502.h"
+
+class M6502VariantTest : public testing::Test
+{
+public:
+    M6502::Mem mem;
+    M6502::CPU cpu;
+    M6502::CPU65C02 cmos;
+    virtual void SetUp()
+    {
+        cpu.Reset(mem);
+        cmos.Reset(mem);
+    }
+};
+
+TEST_F(M6502VariantTest, LDAImmediateIsSharedByBothVariants)
+{
+    // given:
+    mem[0xFFFC] = M6502::CPU::INS_LDA_IM;
+    mem[0xFFFD] = 0x84;
+
+    //when:
+    int nmosCycles = cpu.Execute(2, mem);
+    int cmosCycles = cmos.Execute(2, mem);
+
+    // then:
+    EXPECT_EQ(cpu.A, 0x84);
+    EXPECT_EQ(cmos.A, 0x84);
+    EXPECT_EQ(nmosCycles, 2);
+    EXPECT_EQ(cmosCycles, 2);
+}
+
+TEST_F(M6502VariantTest, JSRAndRTSReturnToTheInstructionAfterTheCall)
+{
+    // given:
+    mem[0xFFFC] = M6502::CPU::INS_JSR;
+    mem[0xFFFD] = 0x00;
+    mem[0xFFFE] = 0x80;
+    mem[0x8000] = M6502::CPU::INS_RTS;
+    mem[0xFFFF] = M6502::CPU::INS_LDA_IM;
+    constexpr int EXPECTED_CYCLES = 6 + 6;
+
+    //when:
+    int cyclesUsed = cpu.Execute(EXPECTED_CYCLES, mem);
+
+    // then:
+    EXPECT_EQ(cyclesUsed, EXPECTED_CYCLES);
+    EXPECT_EQ(cpu.PC, 0xFFFF);
+    EXPECT_EQ(cpu.SP, 0xFF);
+    EXPECT_EQ(mem[0x01FF], 0xFF);
+    EXPECT_EQ(mem[0x01FE], 0xFE);
+}
+
+TEST_F(M6502VariantTest, BranchTakenAcrossAPageCostsTwoExtraCycles)
+{
+    // given:
+    cpu.PC = 0x80F0;
+    mem[0x80F0] = M6502::CPU::INS_BNE;
+    mem[0x80F1] = 0x10;
+    constexpr int EXPECTED_CYCLES = 4;
+
+    //when:
+    int cyclesUsed = cpu.Execute(1, mem);
+
+    // then:
+    EXPECT_EQ(cyclesUsed, EXPECTED_CYCLES);
+    EXPECT_EQ(cpu.PC, 0x8102);
+}
+
+TEST_F(M6502VariantTest, ADCDecimalModeCostsOneMoreCycleOnThe65C02)
+{
+    // given:
+    cpu.D = cmos.D = 1;
+    cpu.A = cmos.A = 0x58;
+    mem[0xFFFC] = M6502::CPU::INS_ADC_IM;
+    mem[0xFFFD] = 0x46;
+
+    //when:
+    int nmosCycles = cpu.Execute(1, mem);
+    int cmosCycles = cmos.Execute(1, mem);
+
+    // then:
+    EXPECT_EQ(cpu.A, 0x04);
+    EXPECT_EQ(cmos.A, 0x04);
+    EXPECT_TRUE(cpu.C);
+    EXPECT_TRUE(cmos.C);
+    EXPECT_EQ(nmosCycles, 2);
+    EXPECT_EQ(cmosCycles, 3);
+}
+
+TEST_F(M6502VariantTest, JMPIndirectOnlyWrapsThePointerOnNMOS)
+{
+    // given:
+    mem[0xFFFC] = M6502::CPU::INS_JMP_IND;
+    mem[0xFFFD] = 0xFF;
+    mem[0xFFFE] = 0x30;
+    mem[0x30FF] = 0x80;
+    mem[0x3000] = 0x40;
+    mem[0x3100] = 0x50;
+
+    //when:
+    int nmosCycles = cpu.Execute(1, mem);
+    int cmosCycles = cmos.Execute(1, mem);
+
+    // then:
+    EXPECT_EQ(cpu.PC, 0x4080);
+    EXPECT_EQ(cmos.PC, 0x5080);
+    EXPECT_EQ(nmosCycles, 5);
+    EXPECT_EQ(cmosCycles, 6);
+}
+
+TEST_F(M6502VariantTest, NMOSLAXLoadsAAndX)
+{
+    // given:
+    mem[0xFFFC] = M6502::CPU::INS_LAX_ZP;
+    mem[0xFFFD] = 0x42;
+    mem[0x0042] = 0x80;
+
+    //when:
+    int cyclesUsed = cpu.Execute(3, mem);
+
+    // then:
+    EXPECT_EQ(cpu.A, 0x80);
+    EXPECT_EQ(cpu.X, 0x80);
+    EXPECT_EQ(cyclesUsed, 3);
+    EXPECT_FALSE(cpu.Z);
+    EXPECT_TRUE(cpu.N);
+}
+
+TEST_F(M6502VariantTest, NMOSSAXStoresAAndX)
+{
+    // given:
+    cpu.A = 0xF0;
+    cpu.X = 0x3C;
+    mem[0xFFFC] = M6502::CPU::INS_SAX_ABS;
+    mem[0xFFFD] = 0x00;
+    mem[0xFFFE] = 0x44;
+
+    //when:
+    int cyclesUsed = cpu.Execute(4, mem);
+
+    // then:
+    EXPECT_EQ(mem[0x4400], 0x30);
+    EXPECT_EQ(cyclesUsed, 4);
+}
+
+TEST_F(M6502VariantTest, NMOSDCPDecrementsThenCompares)
+{
+    // given:
+    cpu.A = 0x41;
+    mem[0xFFFC] = M6502::CPU::INS_DCP_ZP;
+    mem[0xFFFD] = 0x42;
+    mem[0x0042] = 0x42;
+
+    //when:
+    int cyclesUsed = cpu.Execute(5, mem);
+
+    // then:
+    EXPECT_EQ(mem[0x0042], 0x41);
+    EXPECT_EQ(cyclesUsed, 5);
+    EXPECT_TRUE(cpu.Z);
+    EXPECT_TRUE(cpu.C);
+}
+
+TEST_F(M6502VariantTest, NMOSJamHaltsTheCPU)
+{
+    // given:
+    mem[0xFFFC] = M6502::CPU::INS_JAM;
+
+    //when:
+    cpu.Execute(100, mem);
+
+    // then:
+    EXPECT_TRUE(cpu.Halted);
+    EXPECT_EQ(cpu.PC, 0xFFFC);
+}
+
+TEST_F(M6502VariantTest, ExecuteCountsOnlyTheCyclesUsedBeforeAHalt)
+{
+    // given:
+    mem[0xFFFC] = M6502::CPU::INS_LDA_IM;
+    mem[0xFFFD] = 0x42;
+    mem[0xFFFE] = M6502::CPU::INS_JAM;
+
+    //when:
+    int cyclesUsed = cpu.Execute(100, mem);
+    int cyclesUsedHalted = cpu.Execute(100, mem);
+
+    // then:
+    EXPECT_TRUE(cpu.Halted);
+    EXPECT_EQ(cyclesUsed, 3);
+    EXPECT_EQ(cyclesUsedHalted, 1);
+}
+
+TEST_F(M6502VariantTest, CMOSWAIIdlesThroughTheCycles)
+{
+    // given:
+    mem[0xFFFC] = M6502::CPU65C02::INS_WAI;
+
+    //when:
+    int cyclesUsed = cmos.Execute(100, mem);
+
+    // then:
+    EXPECT_TRUE(cmos.Waiting);
+    EXPECT_EQ(cyclesUsed, 100);
+}
+
+TEST_F(M6502VariantTest, Opcode1AIsNOPOnNMOSAndINCAOn65C02)
+{
+    // given:
+    cpu.A = cmos.A = 0x7F;
+    mem[0xFFFC] = M6502::CPU65C02::INS_INC_ACC;
+
+    //when:
+    cpu.Execute(2, mem);
+    cmos.Execute(2, mem);
+
+    // then:
+    EXPECT_EQ(cpu.A, 0x7F);
+    EXPECT_EQ(cmos.A, 0x80);
+    EXPECT_TRUE(cmos.N);
+}
+
+TEST_F(M6502VariantTest, CMOSBRAAlwaysBranches)
+{
+    // given:
+    mem[0xFFFC] = M6502::CPU65C02::INS_BRA;
+    mem[0xFFFD] = 0xFC;
+
+    //when:
+    int cyclesUsed = cmos.Execute(1, mem);
+
+    // then:
+    EXPECT_EQ(cmos.PC, 0xFFFA);
+    EXPECT_EQ(cyclesUsed, 3);
+}
+
+TEST_F(M6502VariantTest, CMOSPHXAndPLYMoveXIntoY)
+{
+    // given:
+    cmos.X = 0x84;
+    mem[0xFFFC] = M6502::CPU65C02::INS_PHX;
+    mem[0xFFFD] = M6502::CPU65C02::INS_PLY;
+
+    //when:
+    int cyclesUsed = cmos.Execute(7, mem);
+
+    // then:
+    EXPECT_EQ(cmos.Y, 0x84);
+    EXPECT_EQ(cyclesUsed, 7);
+    EXPECT_EQ(cmos.SP, 0xFF);
+    EXPECT_TRUE(cmos.N);
+}
+
+TEST_F(M6502VariantTest, CMOSSTZClearsMemory)
+{
+    // given:
+    cmos.X = 0x01;
+    mem[0xFFFC] = M6502::CPU65C02::INS_STZ_ABSX;
+    mem[0xFFFD] = 0x80;
+    mem[0xFFFE] = 0x44;
+    mem[0x4481] = 0x37;
+
+    //when:
+    int cyclesUsed = cmos.Execute(5, mem);
+
+    // then:
+    EXPECT_EQ(mem[0x4481], 0x00);
+    EXPECT_EQ(cyclesUsed, 5);
+}
+
+TEST_F(M6502VariantTest, CMOSTRBAndTSBTestAgainstA)
+{
+    // given:
+    cmos.A = 0x0F;
+    mem[0xFFFC] = M6502::CPU65C02::INS_TRB_ZP;
+    mem[0xFFFD] = 0x42;
+    mem[0xFFFE] = M6502::CPU65C02::INS_TSB_ZP;
+    mem[0xFFFF] = 0x43;
+    mem[0x0042] = 0xFF;
+    mem[0x0043] = 0xF0;
+
+    //when:
+    int cyclesUsed = cmos.Execute(10, mem);
+
+    // then:
+    EXPECT_EQ(mem[0x0042], 0xF0);
+    EXPECT_EQ(mem[0x0043], 0xFF);
+    EXPECT_EQ(cyclesUsed, 10);
+    EXPECT_TRUE(cmos.Z);
+}
+
+TEST_F(M6502VariantTest, CMOSBBSBranchesOnASetBit)
+{
+    // given:
+    mem[0xFFFC] = M6502::CPU65C02::INS_SMB0 + (3 << 4);
+    mem[0xFFFD] = 0x42;
+    mem[0xFFFE] = M6502::CPU65C02::INS_BBS0 + (3 << 4);
+    mem[0xFFFF] = 0x42;
+    mem[0x0000] = 0x10;
+
+    //when:
+    int cyclesUsed = cmos.Execute(11, mem);
+
+    // then:
+    EXPECT_EQ(mem[0x0042], 0x08);
+    EXPECT_EQ(cmos.PC, 0x0011);
+    EXPECT_EQ(cyclesUsed, 11);
+}
+
+TEST_F(M6502VariantTest, IRQPushesPCAndStatusAndJumpsThroughTheVector)
+{
+    // given:
+    cpu.PC = 0x1234;
+    cpu.C = 1;
+    mem[0xFFFE] = 0x00;
+    mem[0xFFFF] = 0x80;
+
+    //when:
+    int cyclesUsed = cpu.IRQ(mem);
+
+    // then:
+    EXPECT_EQ(cyclesUsed, 7);
+    EXPECT_EQ(cpu.PC, 0x8000);
+    EXPECT_TRUE(cpu.I);
+    EXPECT_EQ(cpu.SP, 0xFC);
+    EXPECT_EQ(mem[0x01FF], 0x12);
+    EXPECT_EQ(mem[0x01FE], 0x34);
+    EXPECT_EQ(mem[0x01FD], M6502::CPU::CarryFlagBit | M6502::CPU::UnusedFlagBit);
+}
+
+TEST_F(M6502VariantTest, IRQIsMaskedButNMIIsNot)
+{
+    // given:
+    cpu.PC = 0x1234;
+    cpu.I = 1;
+    mem[0xFFFA] = 0x00;
+    mem[0xFFFB] = 0x90;
+
+    //when:
+    int irqCycles = cpu.IRQ(mem);
+    int nmiCycles = cpu.NMI(mem);
+
+    // then:
+    EXPECT_EQ(irqCycles, 0);
+    EXPECT_EQ(nmiCycles, 7);
+    EXPECT_EQ(cpu.PC, 0x9000);
+}
+
+TEST_F(M6502VariantTest, CMOSMaskedIRQEndsWAI)
+{
+    // given:
+    mem[0xFFFC] = M6502::CPU65C02::INS_WAI;
+    mem[0xFFFD] = M6502::CPU65C02::INS_INX;
+    cmos.I = 1;
+    cmos.Execute(3, mem);
+
+    //when:
+    cmos.IRQ(mem);
+    cmos.Execute(2, mem);
+
+    // then:
+    EXPECT_FALSE(cmos.Waiting);
+    EXPECT_EQ(cmos.X, 1);
+    EXPECT_EQ(cmos.PC, 0xFFFE);
+}
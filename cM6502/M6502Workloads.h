@@ -0,0 +1,564 @@
+#ifndef M6502_WORKLOADS_H
+#define M6502_WORKLOADS_H
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "cM6502.h"
+
+// Small programs used as a corpus by the profiling and tuning tools. Every
+// one of them loops forever, run them for a cycle budget.
+//
+// The benchmark programs end in a JAM instead and Checksum is the
+// StateChecksum of the state they end in.
+
+namespace M6502
+{
+    struct Workload;
+    struct WorkloadImage;
+}
+
+struct M6502::Workload{
+    const char* Name;
+    u16 Load;
+    u16 Entry;
+    const u8* Image;
+    u32 Size;
+    int Cycles;
+    u32 Checksum = 0;
+    int IRQPeriod = 0;
+
+    // Reset, copy the image in and point PC at the entry
+    template<typename CPUType>
+    void Setup(CPUType& cpu, typename CPUType::MemoryType& mem) const
+    {
+        cpu.Reset(mem);
+        for(u32 i = 0; i < Size; i++){
+            mem[Load + i] = Image[i];
+        }
+        cpu.PC = Entry;
+    }
+
+    // Runs until the program halts or Cycles are used up, with an IRQ every
+    // IRQPeriod cycles when that is set.
+    template<typename CPUType>
+    long long Run(CPUType& cpu, typename CPUType::MemoryType& mem) const
+    {
+        constexpr long long SLICE = 1024;
+        long long used = 0;
+        long long nextIRQ = IRQPeriod;
+        while(!cpu.Halted && used < Cycles){
+            long long until = std::min<long long>(used + SLICE, Cycles);
+            if(IRQPeriod > 0){
+                until = std::min(until, nextIRQ);
+            }
+            used += cpu.Execute(until - used, mem);
+            if(IRQPeriod > 0 && used >= nextIRQ){
+                used += cpu.IRQ(mem);
+                nextIRQ += IRQPeriod;
+            }
+        }
+        return used;
+    }
+};
+
+namespace M6502
+{
+    // copy page $10 to page $20 through ($10),Y / ($12),Y
+    inline constexpr u8 MemcpyProgram[] = {
+        0xA9, 0x00,         // 0200 LDA #$00
+        0x85, 0x10,         // 0202 STA $10
+        0x85, 0x12,         // 0204 STA $12
+        0xA9, 0x10,         // 0206 LDA #$10
+        0x85, 0x11,         // 0208 STA $11
+        0xA9, 0x20,         // 020A LDA #$20
+        0x85, 0x13,         // 020C STA $13
+        0xA0, 0x00,         // 020E LDY #$00
+        0xB1, 0x10,         // 0210 LDA ($10),Y
+        0x91, 0x12,         // 0212 STA ($12),Y
+        0xC8,               // 0214 INY
+        0xD0, 0xF9,         // 0215 BNE $0210
+        0xE6, 0x14,         // 0217 INC $14
+        0x4C, 0x00, 0x02,   // 0219 JMP $0200
+    };
+
+    // fill page $30 with the counter in $15
+    inline constexpr u8 MemsetProgram[] = {
+        0xA2, 0x00,         // 0200 LDX #$00
+        0xA5, 0x15,         // 0202 LDA $15
+        0x9D, 0x00, 0x30,   // 0204 STA $3000,X
+        0xE8,               // 0207 INX
+        0xD0, 0xFA,         // 0208 BNE $0204
+        0xE6, 0x15,         // 020A INC $15
+        0x4C, 0x00, 0x02,   // 020C JMP $0200
+    };
+
+    // 8 bit sum of page $10, written to $16
+    inline constexpr u8 ChecksumProgram[] = {
+        0xA0, 0x00,         // 0200 LDY #$00
+        0xA9, 0x00,         // 0202 LDA #$00
+        0x18,               // 0204 CLC
+        0x79, 0x00, 0x10,   // 0205 ADC $1000,Y
+        0xC8,               // 0208 INY
+        0xD0, 0xFA,         // 0209 BNE $0205
+        0x85, 0x16,         // 020B STA $16
+        0xEE, 0x00, 0x10,   // 020D INC $1000
+        0x4C, 0x00, 0x02,   // 0210 JMP $0200
+    };
+
+    // nested DEX/DEY delay loop
+    inline constexpr u8 DelayProgram[] = {
+        0xA0, 0x10,         // 0200 LDY #$10
+        0xA2, 0x00,         // 0202 LDX #$00
+        0xCA,               // 0204 DEX
+        0xD0, 0xFD,         // 0205 BNE $0204
+        0x88,               // 0207 DEY
+        0xD0, 0xF8,         // 0208 BNE $0202
+        0xE6, 0x17,         // 020A INC $17
+        0x4C, 0x00, 0x02,   // 020C JMP $0200
+    };
+
+    // merge flag bytes with an ORA chain
+    inline constexpr u8 FlagsProgram[] = {
+        0xA5, 0x20,         // 0200 LDA $20
+        0x05, 0x21,         // 0202 ORA $21
+        0x05, 0x22,         // 0204 ORA $22
+        0x05, 0x23,         // 0206 ORA $23
+        0x85, 0x24,         // 0208 STA $24
+        0xE6, 0x20,         // 020A INC $20
+        0xA5, 0x20,         // 020C LDA $20
+        0x4A,               // 020E LSR A
+        0x85, 0x22,         // 020F STA $22
+        0x4C, 0x00, 0x02,   // 0211 JMP $0200
+    };
+
+    inline constexpr Workload CorpusWorkloads[] = {
+        {"memcpy", 0x0200, 0x0200, MemcpyProgram, sizeof(MemcpyProgram), 2000000},
+        {"memset", 0x0200, 0x0200, MemsetProgram, sizeof(MemsetProgram), 2000000},
+        {"checksum", 0x0200, 0x0200, ChecksumProgram, sizeof(ChecksumProgram), 2000000},
+        {"delay", 0x0200, 0x0200, DelayProgram, sizeof(DelayProgram), 2000000},
+        {"flags", 0x0200, 0x0200, FlagsProgram, sizeof(FlagsProgram), 2000000},
+    };
+
+    // primes below 8192, flags at $1000-$2FFF, count to $14/$15
+    inline constexpr u8 SieveProgram[] = {
+        0xA9, 0x00,         // 0200 LDA #$00
+        0x85, 0x10,         // 0202 STA $10
+        0xA9, 0x10,         // 0204 LDA #$10
+        0x85, 0x11,         // 0206 STA $11
+        0xA2, 0x20,         // 0208 LDX #$20
+        0xA9, 0x01,         // 020A LDA #$01
+        0xA0, 0x00,         // 020C LDY #$00
+        // fill
+        0x91, 0x10,         // 020E STA ($10),Y
+        0xC8,               // 0210 INY
+        0xD0, 0xFB,         // 0211 BNE $020E
+        0xE6, 0x11,         // 0213 INC $11
+        0xCA,               // 0215 DEX
+        0xD0, 0xF6,         // 0216 BNE $020E
+        0xA9, 0x00,         // 0218 LDA #$00
+        0x8D, 0x00, 0x10,   // 021A STA $1000
+        0x8D, 0x01, 0x10,   // 021D STA $1001
+        0xA9, 0x02,         // 0220 LDA #$02
+        0x85, 0x12,         // 0222 STA $12
+        // outer
+        0xA6, 0x12,         // 0224 LDX $12
+        0xBD, 0x00, 0x10,   // 0226 LDA $1000,X
+        0xF0, 0x23,         // 0229 BEQ $024E
+        0x18,               // 022B CLC
+        0xA5, 0x12,         // 022C LDA $12
+        0x65, 0x12,         // 022E ADC $12
+        0x85, 0x10,         // 0230 STA $10
+        0xA9, 0x10,         // 0232 LDA #$10
+        0x69, 0x00,         // 0234 ADC #$00
+        0x85, 0x11,         // 0236 STA $11
+        // mark
+        0xA9, 0x00,         // 0238 LDA #$00
+        0xA8,               // 023A TAY
+        0x91, 0x10,         // 023B STA ($10),Y
+        0x18,               // 023D CLC
+        0xA5, 0x10,         // 023E LDA $10
+        0x65, 0x12,         // 0240 ADC $12
+        0x85, 0x10,         // 0242 STA $10
+        0xA5, 0x11,         // 0244 LDA $11
+        0x69, 0x00,         // 0246 ADC #$00
+        0x85, 0x11,         // 0248 STA $11
+        0xC9, 0x30,         // 024A CMP #$30
+        0x90, 0xEA,         // 024C BCC $0238
+        // next
+        0xE6, 0x12,         // 024E INC $12
+        0xA5, 0x12,         // 0250 LDA $12
+        0xC9, 0x5B,         // 0252 CMP #$5B
+        0x90, 0xCE,         // 0254 BCC $0224
+        0xA9, 0x00,         // 0256 LDA #$00
+        0x85, 0x14,         // 0258 STA $14
+        0x85, 0x15,         // 025A STA $15
+        0x85, 0x10,         // 025C STA $10
+        0xA9, 0x10,         // 025E LDA #$10
+        0x85, 0x11,         // 0260 STA $11
+        0xA2, 0x20,         // 0262 LDX #$20
+        0xA0, 0x00,         // 0264 LDY #$00
+        // tally
+        0xB1, 0x10,         // 0266 LDA ($10),Y
+        0xF0, 0x06,         // 0268 BEQ $0270
+        0xE6, 0x14,         // 026A INC $14
+        0xD0, 0x02,         // 026C BNE $0270
+        0xE6, 0x15,         // 026E INC $15
+        // skip
+        0xC8,               // 0270 INY
+        0xD0, 0xF3,         // 0271 BNE $0266
+        0xE6, 0x11,         // 0273 INC $11
+        0xCA,               // 0275 DEX
+        0xD0, 0xEE,         // 0276 BNE $0266
+        0x02,               // 0278 JAM
+    };
+
+    // bubble sort of a 256 byte permutation at $1000
+    inline constexpr u8 SortProgram[] = {
+        0xA9, 0x2A,         // 0200 LDA #$2A
+        0xA2, 0x00,         // 0202 LDX #$00
+        // gen
+        0x9D, 0x00, 0x10,   // 0204 STA $1000,X
+        0x85, 0x10,         // 0207 STA $10
+        0x0A,               // 0209 ASL A
+        0x0A,               // 020A ASL A
+        0x18,               // 020B CLC
+        0x65, 0x10,         // 020C ADC $10
+        0x18,               // 020E CLC
+        0x69, 0x11,         // 020F ADC #$11
+        0xE8,               // 0211 INX
+        0xD0, 0xF0,         // 0212 BNE $0204
+        // pass
+        0xA9, 0x00,         // 0214 LDA #$00
+        0x85, 0x11,         // 0216 STA $11
+        0xA2, 0x00,         // 0218 LDX #$00
+        // inner
+        0xBD, 0x00, 0x10,   // 021A LDA $1000,X
+        0xDD, 0x01, 0x10,   // 021D CMP $1001,X
+        0x90, 0x0F,         // 0220 BCC $0231
+        0xF0, 0x0D,         // 0222 BEQ $0231
+        0xA8,               // 0224 TAY
+        0xBD, 0x01, 0x10,   // 0225 LDA $1001,X
+        0x9D, 0x00, 0x10,   // 0228 STA $1000,X
+        0x98,               // 022B TYA
+        0x9D, 0x01, 0x10,   // 022C STA $1001,X
+        0xE6, 0x11,         // 022F INC $11
+        // noswap
+        0xE8,               // 0231 INX
+        0xE0, 0xFF,         // 0232 CPX #$FF
+        0xD0, 0xE4,         // 0234 BNE $021A
+        0xA5, 0x11,         // 0236 LDA $11
+        0xD0, 0xDA,         // 0238 BNE $0214
+        0x02,               // 023A JAM
+    };
+
+    // CRC-32 of the bytes 0..255 repeated over $1000-$13FF, result at $20-$23
+    inline constexpr u8 CRC32Program[] = {
+        0xA2, 0x00,         // 0200 LDX #$00
+        // fill
+        0x8A,               // 0202 TXA
+        0x9D, 0x00, 0x10,   // 0203 STA $1000,X
+        0x9D, 0x00, 0x11,   // 0206 STA $1100,X
+        0x9D, 0x00, 0x12,   // 0209 STA $1200,X
+        0x9D, 0x00, 0x13,   // 020C STA $1300,X
+        0xE8,               // 020F INX
+        0xD0, 0xF0,         // 0210 BNE $0202
+        0xA9, 0xFF,         // 0212 LDA #$FF
+        0x85, 0x20,         // 0214 STA $20
+        0x85, 0x21,         // 0216 STA $21
+        0x85, 0x22,         // 0218 STA $22
+        0x85, 0x23,         // 021A STA $23
+        0xA9, 0x00,         // 021C LDA #$00
+        0x85, 0x10,         // 021E STA $10
+        0xA9, 0x10,         // 0220 LDA #$10
+        0x85, 0x11,         // 0222 STA $11
+        0xA9, 0x04,         // 0224 LDA #$04
+        0x85, 0x12,         // 0226 STA $12
+        0xA0, 0x00,         // 0228 LDY #$00
+        // byte
+        0xB1, 0x10,         // 022A LDA ($10),Y
+        0x45, 0x20,         // 022C EOR $20
+        0x85, 0x20,         // 022E STA $20
+        0xA2, 0x08,         // 0230 LDX #$08
+        // bit
+        0x46, 0x23,         // 0232 LSR $23
+        0x66, 0x22,         // 0234 ROR $22
+        0x66, 0x21,         // 0236 ROR $21
+        0x66, 0x20,         // 0238 ROR $20
+        0x90, 0x18,         // 023A BCC $0254
+        0xA5, 0x23,         // 023C LDA $23
+        0x49, 0xED,         // 023E EOR #$ED
+        0x85, 0x23,         // 0240 STA $23
+        0xA5, 0x22,         // 0242 LDA $22
+        0x49, 0xB8,         // 0244 EOR #$B8
+        0x85, 0x22,         // 0246 STA $22
+        0xA5, 0x21,         // 0248 LDA $21
+        0x49, 0x83,         // 024A EOR #$83
+        0x85, 0x21,         // 024C STA $21
+        0xA5, 0x20,         // 024E LDA $20
+        0x49, 0x20,         // 0250 EOR #$20
+        0x85, 0x20,         // 0252 STA $20
+        // nopoly
+        0xCA,               // 0254 DEX
+        0xD0, 0xDB,         // 0255 BNE $0232
+        0xC8,               // 0257 INY
+        0xD0, 0xD0,         // 0258 BNE $022A
+        0xE6, 0x11,         // 025A INC $11
+        0xC6, 0x12,         // 025C DEC $12
+        0xD0, 0xCA,         // 025E BNE $022A
+        0xA2, 0x03,         // 0260 LDX #$03
+        // final
+        0xB5, 0x20,         // 0262 LDA $20,X
+        0x49, 0xFF,         // 0264 EOR #$FF
+        0x95, 0x20,         // 0266 STA $20,X
+        0xCA,               // 0268 DEX
+        0x10, 0xF7,         // 0269 BPL $0262
+        0x02,               // 026B JAM
+    };
+
+    // decimal mode: count to 10000 in BCD at $30-$33 and add every
+    // count into the BCD sum at $34-$37
+    inline constexpr u8 BCDProgram[] = {
+        0xF8,               // 0200 SED
+        0xA9, 0x10,         // 0201 LDA #$10
+        0x85, 0x10,         // 0203 STA $10
+        0xA9, 0x27,         // 0205 LDA #$27
+        0x85, 0x11,         // 0207 STA $11
+        // loop
+        0x18,               // 0209 CLC
+        0xA5, 0x30,         // 020A LDA $30
+        0x69, 0x01,         // 020C ADC #$01
+        0x85, 0x30,         // 020E STA $30
+        0xA5, 0x31,         // 0210 LDA $31
+        0x69, 0x00,         // 0212 ADC #$00
+        0x85, 0x31,         // 0214 STA $31
+        0xA5, 0x32,         // 0216 LDA $32
+        0x69, 0x00,         // 0218 ADC #$00
+        0x85, 0x32,         // 021A STA $32
+        0xA5, 0x33,         // 021C LDA $33
+        0x69, 0x00,         // 021E ADC #$00
+        0x85, 0x33,         // 0220 STA $33
+        0x18,               // 0222 CLC
+        0xA2, 0xFC,         // 0223 LDX #$FC
+        // add
+        0xB5, 0x38,         // 0225 LDA $38,X
+        0x75, 0x34,         // 0227 ADC $34,X
+        0x95, 0x38,         // 0229 STA $38,X
+        0xE8,               // 022B INX
+        0xD0, 0xF7,         // 022C BNE $0225
+        0xA5, 0x10,         // 022E LDA $10
+        0xD0, 0x02,         // 0230 BNE $0234
+        0xC6, 0x11,         // 0232 DEC $11
+        // low
+        0xC6, 0x10,         // 0234 DEC $10
+        0xA5, 0x10,         // 0236 LDA $10
+        0x05, 0x11,         // 0238 ORA $11
+        0xD0, 0xCD,         // 023A BNE $0209
+        0xD8,               // 023C CLD
+        0x02,               // 023D JAM
+    };
+
+    // bytecode interpreter dispatching through JMP ($xx), runs a hash
+    // loop of 50 x 100 iterations, result at $50
+    inline constexpr u8 InterpreterProgram[] = {
+        0xA0, 0x00,         // 0200 LDY #$00
+        // next
+        0xB9, 0x82, 0x02,   // 0202 LDA $0282,Y
+        0xC8,               // 0205 INY
+        0x0A,               // 0206 ASL A
+        0xAA,               // 0207 TAX
+        0xBD, 0x72, 0x02,   // 0208 LDA $0272,X
+        0x85, 0x42,         // 020B STA $42
+        0xBD, 0x73, 0x02,   // 020D LDA $0273,X
+        0x85, 0x43,         // 0210 STA $43
+        0x6C, 0x42, 0x00,   // 0212 JMP ($0042)
+        // halt
+        0x02,               // 0215 JAM
+        // loadi
+        0xB9, 0x82, 0x02,   // 0216 LDA $0282,Y
+        0xC8,               // 0219 INY
+        0x85, 0x40,         // 021A STA $40
+        0x4C, 0x02, 0x02,   // 021C JMP $0202
+        // loadm
+        0xB9, 0x82, 0x02,   // 021F LDA $0282,Y
+        0xC8,               // 0222 INY
+        0xAA,               // 0223 TAX
+        0xB5, 0x00,         // 0224 LDA $00,X
+        0x85, 0x40,         // 0226 STA $40
+        0x4C, 0x02, 0x02,   // 0228 JMP $0202
+        // addm
+        0xB9, 0x82, 0x02,   // 022B LDA $0282,Y
+        0xC8,               // 022E INY
+        0xAA,               // 022F TAX
+        0xB5, 0x00,         // 0230 LDA $00,X
+        0x18,               // 0232 CLC
+        0x65, 0x40,         // 0233 ADC $40
+        0x85, 0x40,         // 0235 STA $40
+        0x4C, 0x02, 0x02,   // 0237 JMP $0202
+        // xorm
+        0xB9, 0x82, 0x02,   // 023A LDA $0282,Y
+        0xC8,               // 023D INY
+        0xAA,               // 023E TAX
+        0xB5, 0x00,         // 023F LDA $00,X
+        0x45, 0x40,         // 0241 EOR $40
+        0x85, 0x40,         // 0243 STA $40
+        0x4C, 0x02, 0x02,   // 0245 JMP $0202
+        // store
+        0xB9, 0x82, 0x02,   // 0248 LDA $0282,Y
+        0xC8,               // 024B INY
+        0xAA,               // 024C TAX
+        0xA5, 0x40,         // 024D LDA $40
+        0x95, 0x00,         // 024F STA $00,X
+        0x4C, 0x02, 0x02,   // 0251 JMP $0202
+        // rol
+        0xA5, 0x40,         // 0254 LDA $40
+        0x0A,               // 0256 ASL A
+        0x69, 0x00,         // 0257 ADC #$00
+        0x85, 0x40,         // 0259 STA $40
+        0x4C, 0x02, 0x02,   // 025B JMP $0202
+        // decjnz
+        0xB9, 0x82, 0x02,   // 025E LDA $0282,Y
+        0xC8,               // 0261 INY
+        0xAA,               // 0262 TAX
+        0xD6, 0x00,         // 0263 DEC $00,X
+        0xF0, 0x07,         // 0265 BEQ $026E
+        0xB9, 0x82, 0x02,   // 0267 LDA $0282,Y
+        0xA8,               // 026A TAY
+        0x4C, 0x02, 0x02,   // 026B JMP $0202
+        // fall
+        0xC8,               // 026E INY
+        0x4C, 0x02, 0x02,   // 026F JMP $0202
+        // handlers
+        0x15, 0x02, 0x16, 0x02, 0x1F, 0x02, 0x2B, 0x02, // 0272 .word halt, loadi, loadm, addm, xorm, store, rol, decjnz
+        0x3A, 0x02, 0x48, 0x02, 0x54, 0x02, 0x5E, 0x02, // 027A
+        // code
+        0x01, 0x00,         // 0282 LOADI 0
+        0x05, 0x50,         // 0284 STORE $50
+        0x01, 0x32,         // 0286 LOADI 50
+        0x05, 0x51,         // 0288 STORE $51
+        0x01, 0x64,         // 028A LOADI 100
+        0x05, 0x52,         // 028C STORE $52
+        0x02, 0x50,         // 028E LOADM $50
+        0x06,               // 0290 ROL
+        0x04, 0x52,         // 0291 XORM $52
+        0x03, 0x51,         // 0293 ADDM $51
+        0x05, 0x50,         // 0295 STORE $50
+        0x07, 0x52, 0x0C,   // 0297 DECJNZ $52, 12
+        0x07, 0x51, 0x08,   // 029A DECJNZ $51, 8
+        0x00,               // 029D HALT
+    };
+
+    // counts in $60/$61 while an IRQ every 100 cycles ticks $62/$63 and
+    // stirs $64, stops after 10240 ticks
+    inline constexpr u8 TimerProgram[] = {
+        0x78,               // 0200 SEI
+        0xA9, 0x1D,         // 0201 LDA #$1D
+        0x8D, 0xFE, 0xFF,   // 0203 STA $FFFE
+        0xA9, 0x02,         // 0206 LDA #$02
+        0x8D, 0xFF, 0xFF,   // 0208 STA $FFFF
+        0xA2, 0xFF,         // 020B LDX #$FF
+        0x9A,               // 020D TXS
+        0x58,               // 020E CLI
+        // main
+        0xE6, 0x60,         // 020F INC $60
+        0xD0, 0x02,         // 0211 BNE $0215
+        0xE6, 0x61,         // 0213 INC $61
+        // check
+        0xA5, 0x63,         // 0215 LDA $63
+        0xC9, 0x28,         // 0217 CMP #$28
+        0x90, 0xF4,         // 0219 BCC $020F
+        0x78,               // 021B SEI
+        0x02,               // 021C JAM
+        // irq
+        0x48,               // 021D PHA
+        0x8A,               // 021E TXA
+        0x48,               // 021F PHA
+        0xE6, 0x62,         // 0220 INC $62
+        0xD0, 0x02,         // 0222 BNE $0226
+        0xE6, 0x63,         // 0224 INC $63
+        // mix
+        0xA6, 0x62,         // 0226 LDX $62
+        0xA5, 0x64,         // 0228 LDA $64
+        0x0A,               // 022A ASL A
+        0x69, 0x00,         // 022B ADC #$00
+        0x55, 0x62,         // 022D EOR $62,X
+        0x85, 0x64,         // 022F STA $64
+        0x68,               // 0231 PLA
+        0xAA,               // 0232 TAX
+        0x68,               // 0233 PLA
+        0x40,               // 0234 RTI
+    };
+
+    // FNV-1a over the registers, flags and all of memory
+    template<typename CPUType>
+    u32 StateChecksum(const CPUType& cpu, const typename CPUType::MemoryType& mem)
+    {
+        u32 hash = 2166136261u;
+        auto add = [&hash](u8 value){
+            hash = (hash ^ value) * 16777619u;
+        };
+        add(cpu.PC & 0xFF);
+        add(cpu.PC >> 8);
+        add(cpu.SP);
+        add(cpu.A);
+        add(cpu.X);
+        add(cpu.Y);
+        add(cpu.GetStatus());
+        for(u32 address = 0; address < CPUType::MemoryType::MAX_MEM; address++){
+            add(mem[address]);
+        }
+        return hash;
+    }
+
+    inline constexpr Workload BenchmarkWorkloads[] = {
+        {"sieve", 0x0200, 0x0200, SieveProgram, sizeof(SieveProgram), 10000000, 0x78AB5468},
+        {"sort", 0x0200, 0x0200, SortProgram, sizeof(SortProgram), 10000000, 0xFA474034},
+        {"crc32", 0x0200, 0x0200, CRC32Program, sizeof(CRC32Program), 10000000, 0x366FC740},
+        {"bcd", 0x0200, 0x0200, BCDProgram, sizeof(BCDProgram), 10000000, 0xC6E2E337},
+        {"interpreter", 0x0200, 0x0200, InterpreterProgram, sizeof(InterpreterProgram), 10000000, 0x9F44A03B},
+        {"timer", 0x0200, 0x0200, TimerProgram, sizeof(TimerProgram), 10000000, 0x7CC4AB76, 100},
+    };
+}
+
+// a program image loaded from a file, for the tools that take them on the
+// command line as image@load[@entry[@cycles]]
+struct M6502::WorkloadImage{
+    std::string Name;
+    std::vector<u8> Image;
+    u16 Load = 0;
+    u16 Entry = 0;
+    int Cycles = 2000000;
+
+    // points into Name and Image, take it once the images stop moving
+    Workload View() const
+    {
+        return {Name.c_str(), Load, Entry, Image.data(), static_cast<u32>(Image.size()), Cycles};
+    }
+};
+
+namespace M6502
+{
+    inline bool ParseWorkloadImage(const std::string& arg, WorkloadImage& program)
+    {
+        std::vector<std::string> fields;
+        size_t start = 0;
+        for(size_t at; (at = arg.find('@', start)) != std::string::npos; start = at + 1){
+            fields.push_back(arg.substr(start, at - start));
+        }
+        fields.push_back(arg.substr(start));
+        if(fields.size() < 2){
+            return false;
+        }
+        std::ifstream file(fields[0], std::ios::binary);
+        if(!file){
+            return false;
+        }
+        program.Name = fields[0];
+        program.Image.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        program.Load = strtol(fields[1].c_str(), nullptr, 0);
+        program.Entry = fields.size() > 2 ? strtol(fields[2].c_str(), nullptr, 0) : program.Load;
+        program.Cycles = fields.size() > 3 ? strtol(fields[3].c_str(), nullptr, 0) : 2000000;
+        return true;
+    }
+}
+#endif
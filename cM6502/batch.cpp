@@ -0,0 +1,122 @@
+// Headless batch runner.
+//
+// usage: batch [-j threads] [--format ndjson|binary] [manifest]
+//
+// The manifest (stdin when no file is given) holds one job per line as
+// whitespace separated key=value pairs, '#' starts a comment:
+//
+//   image=prog.bin load=0x0200 pc=0x0200 a=0 x=0 y=0 sp=0xFF p=0x24
+//   input=0x0300:0102ff cycles=1000000 stop=halt,brk,pc:0x0210
+//   dump=0x0000:0x100 variant=65c02
+//
+// Numbers are decimal, 0x hex or 0 octal and must fit the register or
+// address they go to, variant is 6502 (the default) or 65c02. A line
+// with anything else gives a result with stop "error".
+// Jobs are read and run a chunk at a time so the whole manifest is never held
+// in memory. Results are written in manifest order. At most 0xFFFF dumps of
+// up to 64KB each are allowed per job.
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "M6502Batch.h"
+
+using namespace M6502;
+
+int main(int argc, char** argv)
+{
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    bool binary = false;
+    const char* manifestPath = nullptr;
+    for(int i = 1; i < argc; i++){
+        bool valued = !strcmp(argv[i], "-j") || !strcmp(argv[i], "--format");
+        if(valued && i + 1 == argc){
+            fprintf(stderr, "usage: batch [-j threads] [--format ndjson|binary] [manifest]\n");
+            return 1;
+        }
+        if(!strcmp(argv[i], "-j")){
+            threads = std::max(1, atoi(argv[++i]));
+        }else if(!strcmp(argv[i], "--format")){
+            std::string format = argv[++i];
+            if(format != "ndjson" && format != "binary"){
+                fprintf(stderr, "usage: batch [-j threads] [--format ndjson|binary] [manifest]\n");
+                return 1;
+            }
+            binary = format == "binary";
+        }else{
+            manifestPath = argv[i];
+        }
+    }
+
+    std::ifstream manifestFile;
+    if(manifestPath){
+        manifestFile.open(manifestPath);
+        if(!manifestFile){
+            fprintf(stderr, "cannot open %s\n", manifestPath);
+            return 1;
+        }
+    }
+    std::istream& manifest = manifestPath ? manifestFile : std::cin;
+
+    const size_t chunkSize = 1024 * threads;
+    std::vector<BatchJob> jobs(chunkSize);
+    std::vector<BatchResult> results(chunkSize);
+    std::vector<std::unique_ptr<Mem>> memories;
+    for(unsigned i = 0; i < threads; i++){
+        memories.emplace_back(new Mem);
+    }
+    BatchImages images;
+
+    u32 nextId = 0;
+    std::string line;
+    std::string out;
+    bool more = true;
+    while(more){
+        size_t count = 0;
+        while(count < chunkSize && (more = static_cast<bool>(std::getline(manifest, line)))){
+            size_t comment = line.find('#');
+            if(comment != std::string::npos){
+                line.erase(comment);
+            }
+            if(line.find_first_not_of(" \t\r") == std::string::npos){
+                continue;
+            }
+            jobs[count] = BatchJob{};
+            jobs[count].id = nextId++;
+            ParseBatchJob(line, jobs[count], images);
+            count++;
+        }
+
+        std::atomic<size_t> next(0);
+        auto worker = [&](unsigned index){
+            for(size_t i = next++; i < count; i = next++){
+                RunBatchJob(jobs[i], *memories[index], results[i]);
+            }
+        };
+        std::vector<std::thread> pool;
+        for(unsigned i = 1; i < threads; i++){
+            pool.emplace_back(worker, i);
+        }
+        worker(0);
+        for(std::thread& thread : pool){
+            thread.join();
+        }
+
+        for(size_t i = 0; i < count; i++){
+            out.clear();
+            if(binary){
+                WriteBatchBinary(results[i], out);
+            }else{
+                WriteBatchJSON(results[i], out);
+            }
+            fwrite(out.data(), 1, out.size(), stdout);
+        }
+        fflush(stdout);
+    }
+    return 0;
+}
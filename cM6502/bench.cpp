@@ -0,0 +1,102 @@
+// Runs the benchmark programs, checks the state each one ends in and
+// reports emulated MHz.
+//
+// usage: bench [-b baseline] [-t percent] [-r file] [-s seconds]
+//
+// With -b every workload has to reach the MHz recorded in the baseline
+// file less the threshold (-t, 15% by default). -r writes the measured MHz
+// as a new baseline. Each workload is repeated for -s seconds, 0.5 by
+// default, and the fastest run counts. Exits with 1 on a wrong checksum or
+// a regression.
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <string>
+#include "M6502Workloads.h"
+
+using namespace M6502;
+
+int main(int argc, char** argv)
+{
+    const char* baselinePath = nullptr;
+    const char* recordPath = nullptr;
+    double threshold = 15;
+    double seconds = 0.5;
+    for(int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        if(i + 1 < argc && arg == "-b"){
+            baselinePath = argv[++i];
+        }else if(i + 1 < argc && arg == "-r"){
+            recordPath = argv[++i];
+        }else if(i + 1 < argc && arg == "-t"){
+            threshold = strtod(argv[++i], nullptr);
+        }else if(i + 1 < argc && arg == "-s"){
+            seconds = strtod(argv[++i], nullptr);
+        }else{
+            fprintf(stderr, "usage: bench [-b baseline] [-t percent] [-r file] [-s seconds]\n");
+            return 1;
+        }
+    }
+
+    std::map<std::string, double> baseline;
+    if(baselinePath){
+        std::ifstream file(baselinePath);
+        if(!file){
+            fprintf(stderr, "cannot read %s\n", baselinePath);
+            return 1;
+        }
+        std::string name;
+        double mhz;
+        while(file >> name >> mhz){
+            baseline[name] = mhz;
+        }
+    }
+
+    std::unique_ptr<Mem> mem(new Mem);
+    std::map<std::string, double> measured;
+    bool failed = false;
+    for(const Workload& workload : BenchmarkWorkloads){
+        CPU cpu;
+        double elapsed = 0;
+        double mhz = 0;
+        u32 checksum = 0;
+        do{
+            workload.Setup(cpu, *mem);
+            auto start = std::chrono::steady_clock::now();
+            long long cycles = workload.Run(cpu, *mem);
+            double run = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            // the fastest run is the least disturbed by the rest of the system
+            mhz = std::max(mhz, cycles / run / 1e6);
+            elapsed += run;
+            checksum = StateChecksum(cpu, *mem);
+        }while(elapsed < seconds && checksum == workload.Checksum);
+        measured[workload.Name] = mhz;
+
+        printf("%-12s %8.1f MHz", workload.Name, mhz);
+        if(checksum != workload.Checksum){
+            printf("  checksum %08X, expected %08X", checksum, workload.Checksum);
+            failed = true;
+        }
+        auto recorded = baseline.find(workload.Name);
+        if(recorded != baseline.end()){
+            double change = 100.0 * (mhz - recorded->second) / recorded->second;
+            printf("  %+6.1f%% against %.1f MHz", change, recorded->second);
+            if(change < -threshold){
+                printf("  regression");
+                failed = true;
+            }
+        }
+        printf("\n");
+    }
+
+    if(recordPath){
+        std::ofstream file(recordPath);
+        for(const auto& result : measured){
+            file << result.first << " " << std::fixed << std::setprecision(1) << result.second << "\n";
+        }
+    }
+    return failed ? 1 : 0;
+}
@@ -3,6 +3,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <cstdint>
+#include <cstring>
 
 // http://www.obelisk.me.uk/6502/
 
@@ -11,47 +12,160 @@ namespace M6502
     using u8 = unsigned char;
     using u16 = unsigned short;
     using u32 = unsigned int;
+    using s8 = signed char;
     struct Mem;
-    struct CPU;
+    struct SparseMem;
+    struct NMOS6502;
+    struct WDC65C02;
+    template<typename Variant, typename MemType = Mem> struct BasicCPU;
+    template<typename CPUType> struct OpcodeTable;
+    using CPU = BasicCPU<NMOS6502>;
+    using CPU65C02 = BasicCPU<WDC65C02>;
 }
 
 
 
 
+// Literal type, a Mem can be built and run on at compile time, see
+// M6502Precompute.h
 struct M6502::Mem{
     static constexpr u32 MAX_MEM = 1024 * 64;
-    u8 data[MAX_MEM];
-    void Initialize()
+    u8 data[MAX_MEM] = {};
+    constexpr void Initialize()
     {
         for(u32 i = 0; i < MAX_MEM; i++){
             data[i] = 0;
         }
     }
-    
+
     // Read one Byte
-    u8 operator[](u32 address) const
+    constexpr u8 operator[](u32 address) const
     {
         return data[address];
     }
 
     // Write one Byte
-    u8& operator[](u32 address)
+    constexpr u8& operator[](u32 address)
     {
         return data[address];
     }
 
     // costs 2 cycles
-    void WriteWord(u16 value, u16 address)
+    constexpr void WriteWord(u16 value, u16 address)
     {
         data[address] = value & 0xFF;
-        data[address + 1] = (value >> 8); 
+        data[address + 1] = (value >> 8);
+    }
+
+    // plain memory has no side effects on any page
+    constexpr bool IsIOPage(u8 page) const
+    {
+        return false;
+    }
+
+};
+
+// Pages are allocated on first write, unwritten pages all read from one shared
+// page of zeros. Costs 2KB of page table per instance instead of 64KB.
+struct M6502::SparseMem{
+    static constexpr u32 MAX_MEM = 1024 * 64;
+    static constexpr u32 PAGE_SIZE = 256;
+    static constexpr u32 NUM_PAGES = MAX_MEM / PAGE_SIZE;
+    inline static u8 ZeroPage[PAGE_SIZE] = {};
+    u8* pages[NUM_PAGES];
+
+    SparseMem()
+    {
+        for(u32 i = 0; i < NUM_PAGES; i++){
+            pages[i] = ZeroPage;
+        }
+    }
+
+    SparseMem(const SparseMem& other) : SparseMem()
+    {
+        *this = other;
+    }
+
+    SparseMem& operator=(const SparseMem& other)
+    {
+        if(this == &other){
+            return *this;
+        }
+        Initialize();
+        for(u32 i = 0; i < NUM_PAGES; i++){
+            if(other.pages[i] != ZeroPage){
+                pages[i] = new u8[PAGE_SIZE];
+                memcpy(pages[i], other.pages[i], PAGE_SIZE);
+            }
+        }
+        return *this;
+    }
+
+    ~SparseMem()
+    {
+        Initialize();
+    }
+
+    void Initialize()
+    {
+        for(u32 i = 0; i < NUM_PAGES; i++){
+            if(pages[i] != ZeroPage){
+                delete[] pages[i];
+                pages[i] = ZeroPage;
+            }
+        }
+    }
+
+    u32 AllocatedPages() const
+    {
+        u32 count = 0;
+        for(u32 i = 0; i < NUM_PAGES; i++){
+            count += pages[i] != ZeroPage;
+        }
+        return count;
+    }
+
+    // Read one Byte
+    u8 operator[](u32 address) const
+    {
+        return pages[address >> 8][address & 0xFF];
+    }
+
+    // Write one Byte, allocates the page
+    u8& operator[](u32 address)
+    {
+        u8*& page = pages[address >> 8];
+        if(page == ZeroPage){
+            page = new u8[PAGE_SIZE]();
+        }
+        return page[address & 0xFF];
     }
 
+    void WriteWord(u16 value, u16 address)
+    {
+        (*this)[address] = value & 0xFF;
+        (*this)[static_cast<u16>(address + 1)] = (value >> 8);
+    }
+
+};
+
+// NMOS 6502, including the stable undocumented opcodes.
+struct M6502::NMOS6502{
+    static constexpr bool CMOS = false;
+};
+
+// WDC 65C02. Adds BRA/PHX/PHY/PLX/PLY/STZ/TRB/TSB, the (zp) addressing
+// mode, RMB/SMB/BBR/BBS and WAI/STP. The undocumented NMOS opcodes are NOPs.
+struct M6502::WDC65C02{
+    static constexpr bool CMOS = true;
 };
 
-struct M6502::CPU{
+// The variant only selects which opcode and cycle table is built at compile
+// time, Execute never looks at it. MemType is Mem or SparseMem.
+template<typename Variant, typename MemType>
+struct M6502::BasicCPU{
     u16 PC;     // program counter
-    u16 SP;     // stack pointer
+    u8 SP;      // stack pointer, offset into page 1
 
     u8 A, X, Y; // registers
 
@@ -64,51 +178,192 @@ struct M6502::CPU{
     u8 V:1;
     u8 N:1;
 
-    u8 FetchByte(Mem& mem)
+    bool Halted;    // JAM, STP or an unhandled opcode
+    bool Waiting;   // WAI
+    int Leftover;   // cycles a halt left unused, see Used
+
+    // all zero, Reset sets the power on state
+    constexpr BasicCPU()
+        : PC(0), SP(0), A(0), X(0), Y(0), C(0), Z(0), I(0), D(0), B(0), V(0), N(0), Halted(false), Waiting(false),
+          Leftover(0)
+    {
+    }
+
+    static constexpr u8
+                        CarryFlagBit = 0b00000001,
+                        ZeroFlagBit = 0b00000010,
+                        InterruptFlagBit = 0b00000100,
+                        DecimalFlagBit = 0b00001000,
+                        BreakFlagBit = 0b00010000,
+                        UnusedFlagBit = 0b00100000,
+                        OverflowFlagBit = 0b01000000,
+                        NegativeFlagBit = 0b10000000;
+
+    using MemoryType = MemType;
+    using VariantType = Variant;
+    using Handler = void (*)(BasicCPU&, MemType&, int&);
+
+    // Base cycles per opcode. Handlers only subtract the extra cycles for
+    // page crossings, taken branches and decimal mode.
+    struct OpTable{
+        Handler Handlers[256];
+        u8 Cycles[256];
+    };
+
+    enum AddrMode{
+        IM, ZP, ZPX, ZPY, ABS, ABSX, ABSY, INDX, INDY,
+        ZPI     // 65C02 (zp)
+    };
+
+    constexpr u8 FetchByte(MemType& mem)
     {
-        u8 data = mem[PC];
+        u8 data = ReadByte(PC, mem);
         PC++;
         return data;
     }
 
-    u8 ReadByteZPage(u8 address, Mem& mem)
+    constexpr u8 ReadByteZPage(u8 address, MemType& mem)
     {
-        return mem[address];
+        return ReadByte(address, mem);
     }
 
-    u8 ReadByte(u16 address, Mem& mem)
+    // reads go through the const operator[] so SparseMem does not allocate
+    constexpr u8 ReadByte(u16 address, MemType& mem)
     {
-        return mem[address];
+        return static_cast<const MemType&>(mem)[address];
     }
 
-    u16 ReadWord(u16 address, Mem& mem)
+    constexpr u16 ReadWord(u16 address, MemType& mem)
     {
         u8 lowByte = ReadByte(address, mem);
         u8 highByte = ReadByte(address + 1, mem);
         return (highByte << 8)|lowByte;
     }
 
-    u16 FetchWord(Mem& mem)
+    // pointer fetches wrap around inside the zero page
+    constexpr u16 ReadWordZPage(u8 address, MemType& mem)
+    {
+        u8 lowByte = ReadByteZPage(address, mem);
+        u8 highByte = ReadByteZPage(static_cast<u8>(address + 1), mem);
+        return (highByte << 8)|lowByte;
+    }
+
+    constexpr void WriteByte(u8 value, u16 address, MemType& mem)
+    {
+        mem[address] = value;
+    }
+
+    constexpr u16 FetchWord(MemType& mem)
     {
         // 6502 is little endian
-        u16 data = mem[PC];
+        u16 data = ReadByte(PC, mem);
         PC++;
-        data |= (mem[PC] << 8);
+        data |= (ReadByte(PC, mem) << 8);
         PC++;
         return data;
     }
 
-    void Reset(Mem& mem)
+    constexpr void PushByte(u8 value, MemType& mem)
+    {
+        WriteByte(value, 0x0100 | SP, mem);
+        SP--;
+    }
+
+    constexpr u8 PopByte(MemType& mem)
+    {
+        SP++;
+        return ReadByte(0x0100 | SP, mem);
+    }
+
+    constexpr void PushWord(u16 value, MemType& mem)
+    {
+        PushByte(value >> 8, mem);
+        PushByte(value & 0xFF, mem);
+    }
+
+    constexpr u16 PopWord(MemType& mem)
+    {
+        u8 lowByte = PopByte(mem);
+        u8 highByte = PopByte(mem);
+        return (highByte << 8)|lowByte;
+    }
+
+    constexpr u8 GetStatus() const
+    {
+        return (C ? CarryFlagBit : 0) |
+               (Z ? ZeroFlagBit : 0) |
+               (I ? InterruptFlagBit : 0) |
+               (D ? DecimalFlagBit : 0) |
+               (B ? BreakFlagBit : 0) |
+               UnusedFlagBit |
+               (V ? OverflowFlagBit : 0) |
+               (N ? NegativeFlagBit : 0);
+    }
+
+    // B is not a real register, pulling the status leaves it alone
+    constexpr void SetStatus(u8 status)
+    {
+        C = (status & CarryFlagBit) != 0;
+        Z = (status & ZeroFlagBit) != 0;
+        I = (status & InterruptFlagBit) != 0;
+        D = (status & DecimalFlagBit) != 0;
+        V = (status & OverflowFlagBit) != 0;
+        N = (status & NegativeFlagBit) != 0;
+    }
+
+    constexpr void Reset(MemType& mem)
     {
         PC = 0xFFFC;
-        SP = 0x00FF;
+        SP = 0xFF;
         C = Z = I = D = B = V = N = 0;
         A = X = Y = 0;
+        Halted = Waiting = false;
         mem.Initialize();
     }
-    
+
+    // Interrupts are taken between instructions, raise them between calls
+    // to Execute. They return the cycles the interrupt sequence took.
+    constexpr int IRQ(MemType& mem)
+    {
+        if(I){
+            // a masked IRQ still ends WAI, execution goes on after it
+            WakeUp();
+            return 0;
+        }
+        return Interrupt(0xFFFE, mem);
+    }
+
+    constexpr int NMI(MemType& mem)
+    {
+        return Interrupt(0xFFFA, mem);
+    }
+
+    constexpr void WakeUp()
+    {
+        if(Waiting){
+            Waiting = false;
+            PC++;
+        }
+    }
+
+    constexpr int Interrupt(u16 vector, MemType& mem)
+    {
+        if(Halted){
+            return 0;
+        }
+        WakeUp();
+        PushWord(PC, mem);
+        PushByte(GetStatus() & ~BreakFlagBit, mem);
+        PC = ReadWord(vector, mem);
+        I = 1;
+        if constexpr(Variant::CMOS){
+            D = 0;
+        }
+        return 7;
+    }
+
     // opcodes
-    static constexpr u8 
+    static constexpr u8
                         INS_BRK = 0x00,
                         // ORA
                         INS_ORA_IM = 0x09,
@@ -119,6 +374,62 @@ struct M6502::CPU{
                         INS_ORA_ABSY = 0x19,
                         INS_ORA_INDX = 0x01,
                         INS_ORA_INDY = 0x11,
+                        // AND
+                        INS_AND_IM = 0x29,
+                        INS_AND_ZP = 0x25,
+                        INS_AND_ZPX = 0x35,
+                        INS_AND_ABS = 0x2D,
+                        INS_AND_ABSX = 0x3D,
+                        INS_AND_ABSY = 0x39,
+                        INS_AND_INDX = 0x21,
+                        INS_AND_INDY = 0x31,
+                        // EOR
+                        INS_EOR_IM = 0x49,
+                        INS_EOR_ZP = 0x45,
+                        INS_EOR_ZPX = 0x55,
+                        INS_EOR_ABS = 0x4D,
+                        INS_EOR_ABSX = 0x5D,
+                        INS_EOR_ABSY = 0x59,
+                        INS_EOR_INDX = 0x41,
+                        INS_EOR_INDY = 0x51,
+                        // ADC
+                        INS_ADC_IM = 0x69,
+                        INS_ADC_ZP = 0x65,
+                        INS_ADC_ZPX = 0x75,
+                        INS_ADC_ABS = 0x6D,
+                        INS_ADC_ABSX = 0x7D,
+                        INS_ADC_ABSY = 0x79,
+                        INS_ADC_INDX = 0x61,
+                        INS_ADC_INDY = 0x71,
+                        // SBC
+                        INS_SBC_IM = 0xE9,
+                        INS_SBC_ZP = 0xE5,
+                        INS_SBC_ZPX = 0xF5,
+                        INS_SBC_ABS = 0xED,
+                        INS_SBC_ABSX = 0xFD,
+                        INS_SBC_ABSY = 0xF9,
+                        INS_SBC_INDX = 0xE1,
+                        INS_SBC_INDY = 0xF1,
+                        // CMP
+                        INS_CMP_IM = 0xC9,
+                        INS_CMP_ZP = 0xC5,
+                        INS_CMP_ZPX = 0xD5,
+                        INS_CMP_ABS = 0xCD,
+                        INS_CMP_ABSX = 0xDD,
+                        INS_CMP_ABSY = 0xD9,
+                        INS_CMP_INDX = 0xC1,
+                        INS_CMP_INDY = 0xD1,
+                        // CPX
+                        INS_CPX_IM = 0xE0,
+                        INS_CPX_ZP = 0xE4,
+                        INS_CPX_ABS = 0xEC,
+                        // CPY
+                        INS_CPY_IM = 0xC0,
+                        INS_CPY_ZP = 0xC4,
+                        INS_CPY_ABS = 0xCC,
+                        // BIT
+                        INS_BIT_ZP = 0x24,
+                        INS_BIT_ABS = 0x2C,
                         // LDA
                         INS_LDA_IM = 0xA9,
                         INS_LDA_ZP = 0xA5,
@@ -140,320 +451,1349 @@ struct M6502::CPU{
                         INS_LDY_ZPX = 0xB4,
                         INS_LDY_ABS = 0xAC,
                         INS_LDY_ABSX = 0xBC,
-                        INS_JSR = 0x20;
-    void LDASetStatus()
+                        // STA
+                        INS_STA_ZP = 0x85,
+                        INS_STA_ZPX = 0x95,
+                        INS_STA_ABS = 0x8D,
+                        INS_STA_ABSX = 0x9D,
+                        INS_STA_ABSY = 0x99,
+                        INS_STA_INDX = 0x81,
+                        INS_STA_INDY = 0x91,
+                        // STX
+                        INS_STX_ZP = 0x86,
+                        INS_STX_ZPY = 0x96,
+                        INS_STX_ABS = 0x8E,
+                        // STY
+                        INS_STY_ZP = 0x84,
+                        INS_STY_ZPX = 0x94,
+                        INS_STY_ABS = 0x8C,
+                        // ASL
+                        INS_ASL_ACC = 0x0A,
+                        INS_ASL_ZP = 0x06,
+                        INS_ASL_ZPX = 0x16,
+                        INS_ASL_ABS = 0x0E,
+                        INS_ASL_ABSX = 0x1E,
+                        // LSR
+                        INS_LSR_ACC = 0x4A,
+                        INS_LSR_ZP = 0x46,
+                        INS_LSR_ZPX = 0x56,
+                        INS_LSR_ABS = 0x4E,
+                        INS_LSR_ABSX = 0x5E,
+                        // ROL
+                        INS_ROL_ACC = 0x2A,
+                        INS_ROL_ZP = 0x26,
+                        INS_ROL_ZPX = 0x36,
+                        INS_ROL_ABS = 0x2E,
+                        INS_ROL_ABSX = 0x3E,
+                        // ROR
+                        INS_ROR_ACC = 0x6A,
+                        INS_ROR_ZP = 0x66,
+                        INS_ROR_ZPX = 0x76,
+                        INS_ROR_ABS = 0x6E,
+                        INS_ROR_ABSX = 0x7E,
+                        // INC
+                        INS_INC_ZP = 0xE6,
+                        INS_INC_ZPX = 0xF6,
+                        INS_INC_ABS = 0xEE,
+                        INS_INC_ABSX = 0xFE,
+                        // DEC
+                        INS_DEC_ZP = 0xC6,
+                        INS_DEC_ZPX = 0xD6,
+                        INS_DEC_ABS = 0xCE,
+                        INS_DEC_ABSX = 0xDE,
+                        // register increments
+                        INS_INX = 0xE8,
+                        INS_INY = 0xC8,
+                        INS_DEX = 0xCA,
+                        INS_DEY = 0x88,
+                        // transfers
+                        INS_TAX = 0xAA,
+                        INS_TAY = 0xA8,
+                        INS_TXA = 0x8A,
+                        INS_TYA = 0x98,
+                        INS_TSX = 0xBA,
+                        INS_TXS = 0x9A,
+                        // stack
+                        INS_PHA = 0x48,
+                        INS_PHP = 0x08,
+                        INS_PLA = 0x68,
+                        INS_PLP = 0x28,
+                        // flags
+                        INS_CLC = 0x18,
+                        INS_SEC = 0x38,
+                        INS_CLI = 0x58,
+                        INS_SEI = 0x78,
+                        INS_CLV = 0xB8,
+                        INS_CLD = 0xD8,
+                        INS_SED = 0xF8,
+                        // branches
+                        INS_BPL = 0x10,
+                        INS_BMI = 0x30,
+                        INS_BVC = 0x50,
+                        INS_BVS = 0x70,
+                        INS_BCC = 0x90,
+                        INS_BCS = 0xB0,
+                        INS_BNE = 0xD0,
+                        INS_BEQ = 0xF0,
+                        // jumps
+                        INS_JMP_ABS = 0x4C,
+                        INS_JMP_IND = 0x6C,
+                        INS_JSR = 0x20,
+                        INS_RTS = 0x60,
+                        INS_RTI = 0x40,
+                        INS_NOP = 0xEA,
+                        // NMOS undocumented
+                        INS_SLO_ZP = 0x07,
+                        INS_SLO_ZPX = 0x17,
+                        INS_SLO_ABS = 0x0F,
+                        INS_SLO_ABSX = 0x1F,
+                        INS_SLO_ABSY = 0x1B,
+                        INS_SLO_INDX = 0x03,
+                        INS_SLO_INDY = 0x13,
+                        INS_RLA_ZP = 0x27,
+                        INS_RLA_ZPX = 0x37,
+                        INS_RLA_ABS = 0x2F,
+                        INS_RLA_ABSX = 0x3F,
+                        INS_RLA_ABSY = 0x3B,
+                        INS_RLA_INDX = 0x23,
+                        INS_RLA_INDY = 0x33,
+                        INS_SRE_ZP = 0x47,
+                        INS_SRE_ZPX = 0x57,
+                        INS_SRE_ABS = 0x4F,
+                        INS_SRE_ABSX = 0x5F,
+                        INS_SRE_ABSY = 0x5B,
+                        INS_SRE_INDX = 0x43,
+                        INS_SRE_INDY = 0x53,
+                        INS_RRA_ZP = 0x67,
+                        INS_RRA_ZPX = 0x77,
+                        INS_RRA_ABS = 0x6F,
+                        INS_RRA_ABSX = 0x7F,
+                        INS_RRA_ABSY = 0x7B,
+                        INS_RRA_INDX = 0x63,
+                        INS_RRA_INDY = 0x73,
+                        INS_SAX_ZP = 0x87,
+                        INS_SAX_ZPY = 0x97,
+                        INS_SAX_ABS = 0x8F,
+                        INS_SAX_INDX = 0x83,
+                        INS_LAX_ZP = 0xA7,
+                        INS_LAX_ZPY = 0xB7,
+                        INS_LAX_ABS = 0xAF,
+                        INS_LAX_ABSY = 0xBF,
+                        INS_LAX_INDX = 0xA3,
+                        INS_LAX_INDY = 0xB3,
+                        INS_DCP_ZP = 0xC7,
+                        INS_DCP_ZPX = 0xD7,
+                        INS_DCP_ABS = 0xCF,
+                        INS_DCP_ABSX = 0xDF,
+                        INS_DCP_ABSY = 0xDB,
+                        INS_DCP_INDX = 0xC3,
+                        INS_DCP_INDY = 0xD3,
+                        INS_ISC_ZP = 0xE7,
+                        INS_ISC_ZPX = 0xF7,
+                        INS_ISC_ABS = 0xEF,
+                        INS_ISC_ABSX = 0xFF,
+                        INS_ISC_ABSY = 0xFB,
+                        INS_ISC_INDX = 0xE3,
+                        INS_ISC_INDY = 0xF3,
+                        INS_ANC_IM = 0x0B,
+                        INS_ALR_IM = 0x4B,
+                        INS_ARR_IM = 0x6B,
+                        INS_SBX_IM = 0xCB,
+                        INS_LAS_ABSY = 0xBB,
+                        INS_JAM = 0x02,
+                        // 65C02
+                        INS_BRA = 0x80,
+                        INS_PHX = 0xDA,
+                        INS_PHY = 0x5A,
+                        INS_PLX = 0xFA,
+                        INS_PLY = 0x7A,
+                        INS_STZ_ZP = 0x64,
+                        INS_STZ_ZPX = 0x74,
+                        INS_STZ_ABS = 0x9C,
+                        INS_STZ_ABSX = 0x9E,
+                        INS_TRB_ZP = 0x14,
+                        INS_TRB_ABS = 0x1C,
+                        INS_TSB_ZP = 0x04,
+                        INS_TSB_ABS = 0x0C,
+                        INS_BIT_IM = 0x89,
+                        INS_BIT_ZPX = 0x34,
+                        INS_BIT_ABSX = 0x3C,
+                        INS_INC_ACC = 0x1A,
+                        INS_DEC_ACC = 0x3A,
+                        INS_ORA_ZPI = 0x12,
+                        INS_AND_ZPI = 0x32,
+                        INS_EOR_ZPI = 0x52,
+                        INS_ADC_ZPI = 0x72,
+                        INS_STA_ZPI = 0x92,
+                        INS_LDA_ZPI = 0xB2,
+                        INS_CMP_ZPI = 0xD2,
+                        INS_SBC_ZPI = 0xF2,
+                        INS_JMP_ABSXI = 0x7C,
+                        INS_WAI = 0xCB,
+                        INS_STP = 0xDB,
+                        // 65C02 bit instructions, bit n is added as n << 4
+                        INS_RMB0 = 0x07,
+                        INS_SMB0 = 0x87,
+                        INS_BBR0 = 0x0F,
+                        INS_BBS0 = 0x8F;
+
+    constexpr void SetZeroAndNegative(u8 value)
+    {
+        Z = (value == 0);
+        N = (value & 0b10000000) > 0;
+    }
+
+    constexpr void LDASetStatus()
     {
         Z = (A == 0);
-        N = (A & 0b10000000) > 0;       
+        N = (A & 0b10000000) > 0;
     }
 
-    void LDXSetStatus()
+    constexpr void LDXSetStatus()
     {
         Z = (X == 0);
-        N = (X & 0b10000000) > 0;       
+        N = (X & 0b10000000) > 0;
     }
 
-    void LDYSetStatus()
+    constexpr void LDYSetStatus()
     {
         Z = (Y == 0);
-        N = (Y & 0b10000000) > 0;       
+        N = (Y & 0b10000000) > 0;
     }
 
-    int Execute(int cycles, Mem& mem)
+    // effective address of the operand, PagePenalty charges the extra read
+    // cycle of indexed loads that cross a page
+    template<AddrMode Mode, bool PagePenalty>
+    constexpr u16 Address(MemType& mem, int& cycles)
     {
-        int requestedCycles = cycles;
-        while(cycles > 0){
-            u8 ins = FetchByte(mem);
-            cycles--;
-            switch(ins){
-                case INS_BRK:
-                {
-                    u8 value = FetchByte(mem);
-                    cycles--;
-                    mem.WriteWord(PC, SP);
-                    cycles -= 2;
-                    SP++;
-                    PC = ReadWord(0xFFFE, mem);
-                    cycles -=2;
-                    B = 1;
-                    cycles--;
-
-                }break;
-                case INS_ORA_IM:
-                {
-                    u8 value = FetchByte(mem);
-                    cycles--;
-                    A |= value;
-                    LDASetStatus();
-                }break; 
-                case INS_ORA_ZP:
-                {
-                    u8 address = FetchByte(mem);
-                    cycles--;
-                    A |= ReadByte(address, mem);
-                    cycles--;
-                    LDASetStatus();
-                }break;
-                case INS_ORA_ZPX:
-                {
-                    u8 zPageAdd = FetchByte(mem);
-                    cycles--;
-                    zPageAdd += X;
-                    cycles--;
-                    A |= ReadByteZPage(zPageAdd, mem);
-                    cycles--;
-                    LDASetStatus();
-                }break;   
-                case INS_ORA_ABS:
-                {
-                    u16 absAddress = FetchWord(mem);
-                    cycles -= 2;
-                    A |= ReadByte(absAddress, mem);
-                    cycles--;
-                    LDASetStatus();
-                }break;  
-                case INS_ORA_ABSX:
-                {
-                    u16 absAddress = FetchWord(mem);
-                    cycles -= 2;
-                    if((absAddress & 0x00FF) + X > 0xFF){
-                        cycles--;
-                    }
-                    absAddress += X;
-                    A |= ReadByte(absAddress, mem);
-                    cycles--;
-                    LDASetStatus();
-                }break; 
-                case INS_ORA_ABSY:
-                {
-                    u16 absAddress = FetchWord(mem);
-                    cycles -= 2;
-                    if((absAddress & 0x00FF) + Y > 0xFF){
-                        cycles--;
-                    }
-                    absAddress += Y;
-                    A |= ReadByte(absAddress, mem);
-                    cycles--;
-                    LDASetStatus();
-                }break;
-                case INS_ORA_INDX:
-                {
-                    u16 zPageAddress = FetchByte(mem);
-                    cycles--;
-                    zPageAddress += X;
-                    cycles--;
-                    u16 targetAddress = ReadWord(zPageAddress, mem);
-                    cycles -= 2;
-                    A |= ReadByte(targetAddress, mem);
-                    cycles--;
-                    LDASetStatus();
-                }break; 
-                case INS_ORA_INDY:
-                {
-                    u16 zPageAddress = FetchByte(mem);
-                    cycles--;
-                    u16 targetAddress = ReadWord(zPageAddress, mem);
-                    cycles -= 2;
-                    if((targetAddress&0x00FF) + Y > 0xFF){
-                        cycles--;
-                    }
-                    targetAddress += Y;
-                    A |= ReadByte(targetAddress, mem);
-                    cycles--;
-                    LDASetStatus();
-                }break; 
-                case INS_LDA_IM:
-                {
-                    u8 value = FetchByte(mem);
-                    cycles--;
-                    A = value;
-                    LDASetStatus();
-                }break;               
-                case INS_LDA_ZP:
-                {
-                    u8 address = FetchByte(mem);
-                    cycles--;
-                    A = ReadByteZPage(address, mem);
-                    cycles--;
-                    LDASetStatus();
-                }break;
-                case INS_LDA_ZPX:
-                {
-                    u8 zPageAdd = FetchByte(mem);
-                    cycles--;
-                    zPageAdd += X;
-                    cycles--;
-                    A = ReadByteZPage(zPageAdd, mem);
-                    cycles--;
-                    LDASetStatus();
-                }break;
-                case INS_LDA_ABS:
-                {
-                    u16 absAddress = FetchWord(mem);
-                    cycles -= 2;
-                    A = ReadByte(absAddress, mem);
-                    cycles--;
-                    LDASetStatus();
-                }break;
-                case INS_LDA_ABSX:
-                {
-                    u16 absAddress = FetchWord(mem);
-                    cycles -= 2;
-                    if((absAddress & 0x00FF) + X > 0xFF){
-                        cycles--;
-                    }
-                    absAddress += X;
-                    A = ReadByte(absAddress, mem);
-                    cycles--;
-                    LDASetStatus();
-                }break;
-                case INS_LDA_ABSY:
-                {
-                    u16 absAddress = FetchWord(mem);
-                    cycles -= 2;
-                    if((absAddress & 0x00FF) + Y > 0xFF){
-                        cycles--;
-                    }
-                    absAddress += Y;
-                    A = ReadByte(absAddress, mem);
-                    cycles--;
-                    LDASetStatus();
-                }break;
-                case INS_LDA_INDX:
-                {
-                    u16 zPageAddress = FetchByte(mem);
-                    cycles--;
-                    zPageAddress += X;
-                    cycles--;
-                    u16 targetAddress = ReadWord(zPageAddress, mem);
-                    cycles -= 2;
-                    A = ReadByte(targetAddress, mem);
-                    cycles--;
-                    LDASetStatus();
-                }break; 
-                case INS_LDA_INDY:
-                {
-                    u16 zPageAddress = FetchByte(mem);
-                    cycles--;
-                    u16 targetAddress = ReadWord(zPageAddress, mem);
-                    cycles -= 2;
-                    if((targetAddress&0x00FF) + Y > 0xFF){
-                        cycles--;
-                    }
-                    targetAddress += Y;
-                    A = ReadByte(targetAddress, mem);
-                    cycles--;
-                    LDASetStatus();
-                }break;
-                case INS_LDX_IM:
-                {
-                    u8 value = FetchByte(mem);
-                    cycles--;
-                    X = value;
-                    LDXSetStatus();
-                }break;
-                case INS_LDX_ZP:
-                {
-                    u8 address = FetchByte(mem);
-                    cycles--;
-                    X = ReadByteZPage(address, mem);
-                    cycles--;
-                    LDXSetStatus();
-                }break;
-                case INS_LDX_ZPY:
-                {
-                    u8 zPageAdd = FetchByte(mem);
-                    cycles--;
-                    zPageAdd += Y;
-                    cycles--;
-                    X = ReadByteZPage(zPageAdd, mem);
-                    cycles--;
-                    LDXSetStatus();
-                }break;
-                case INS_LDX_ABS:
-                {
-                    u16 absAddress = FetchWord(mem);
-                    cycles -= 2;
-                    X = ReadByte(absAddress, mem);
-                    cycles--;
-                    LDXSetStatus();
-                }break;
-                case INS_LDX_ABSY:
-                {
-                    u16 absAddress = FetchWord(mem);
-                    cycles -= 2;
-                    if((absAddress & 0x00FF) + Y > 0xFF){
-                        cycles--;
-                    }
-                    absAddress += Y;
-                    X = ReadByte(absAddress, mem);
-                    cycles--;
-                    LDXSetStatus();
-                }break;
-                case INS_LDY_IM:
-                {
-                    u8 value = FetchByte(mem);
-                    cycles--;
-                    Y = value;
-                    LDYSetStatus();
-                }break;
-                case INS_LDY_ZP:
-                {
-                    u8 address = FetchByte(mem);
-                    cycles--;
-                    Y = ReadByteZPage(address, mem);
-                    cycles--;
-                    LDYSetStatus();
-                }break; 
-                case INS_LDY_ZPX:
-                {
-                    u8 zPageAdd = FetchByte(mem);
-                    cycles--;
-                    zPageAdd += X;
-                    cycles--;
-                    Y = ReadByteZPage(zPageAdd, mem);
-                    cycles--;
-                    LDYSetStatus();
-                }break;
-                case INS_LDY_ABS:
-                {
-                    u16 absAddress = FetchWord(mem);
-                    cycles -= 2;
-                    Y = ReadByte(absAddress, mem);
-                    cycles--;
-                    LDYSetStatus();
-                }break;
-                case INS_LDY_ABSX:
-                {
-                    u16 absAddress = FetchWord(mem);
-                    cycles -= 2;
-                    if((absAddress & 0x00FF) + X > 0xFF){
-                        cycles--;
-                    }
-                    absAddress += X;
-                    Y = ReadByte(absAddress, mem);
-                    cycles--;
-                    LDYSetStatus();
-                }break;            
-                case INS_JSR:
-                {
-                    u16 subAddr = FetchWord(mem);
-                    cycles--;
-                    mem.WriteWord(PC - 1, SP);
-                    cycles -= 2;
-                    SP++;
-                    cycles--;
-                    PC = subAddr;
-                    cycles--;
-                }
-                default:
-                    std::cout << "Instruction: " << static_cast<int>(ins) << " not handled" << std::endl;
-                    cycles = - 1;
-                    requestedCycles = 0;
-                    break;
+        if constexpr(Mode == IM){
+            return PC++;
+        }else if constexpr(Mode == ZP){
+            return FetchByte(mem);
+        }else if constexpr(Mode == ZPX){
+            return static_cast<u8>(FetchByte(mem) + X);
+        }else if constexpr(Mode == ZPY){
+            return static_cast<u8>(FetchByte(mem) + Y);
+        }else if constexpr(Mode == ABS){
+            return FetchWord(mem);
+        }else if constexpr(Mode == ABSX){
+            return Indexed<PagePenalty>(FetchWord(mem), X, cycles);
+        }else if constexpr(Mode == ABSY){
+            return Indexed<PagePenalty>(FetchWord(mem), Y, cycles);
+        }else if constexpr(Mode == INDX){
+            return ReadWordZPage(static_cast<u8>(FetchByte(mem) + X), mem);
+        }else if constexpr(Mode == INDY){
+            return Indexed<PagePenalty>(ReadWordZPage(FetchByte(mem), mem), Y, cycles);
+        }else{
+            return ReadWordZPage(FetchByte(mem), mem);
+        }
+    }
+
+    template<bool PagePenalty>
+    static constexpr u16 Indexed(u16 address, u8 index, int& cycles)
+    {
+        if constexpr(PagePenalty){
+            if((address & 0x00FF) + index > 0xFF){
+                cycles--;
+            }
+        }
+        return address + index;
+    }
+
+    template<AddrMode Mode>
+    constexpr u8 ReadOperand(MemType& mem, int& cycles)
+    {
+        return ReadByte(Address<Mode, true>(mem, cycles), mem);
+    }
+
+    // ALU
+    constexpr void AddWithCarry(u8 value)
+    {
+        if(D){
+            DecimalAdd(value);
+            return;
+        }
+        u16 sum = A + value + C;
+        V = ((~(A ^ value) & (A ^ sum)) & 0x80) != 0;
+        C = sum > 0xFF;
+        A = static_cast<u8>(sum);
+        LDASetStatus();
+    }
+
+    constexpr void DecimalAdd(u8 value)
+    {
+        int binary = A + value + C;
+        int lo = (A & 0x0F) + (value & 0x0F) + C;
+        if(lo > 0x09){
+            lo += 0x06;
+        }
+        int hi = (A >> 4) + (value >> 4) + (lo > 0x0F);
+        // NMOS takes Z from the binary sum and N/V from the intermediate
+        Z = (binary & 0xFF) == 0;
+        N = (hi & 0x08) != 0;
+        V = ((~(A ^ value) & (A ^ (hi << 4))) & 0x80) != 0;
+        if(hi > 0x09){
+            hi += 0x06;
+        }
+        C = hi > 0x0F;
+        A = static_cast<u8>((hi << 4) | (lo & 0x0F));
+        if constexpr(Variant::CMOS){
+            LDASetStatus();
+        }
+    }
+
+    constexpr void SubtractWithCarry(u8 value)
+    {
+        if(!D){
+            AddWithCarry(~value);
+            return;
+        }
+        int borrow = 1 - C;
+        int binary = A - value - borrow;
+        int lo = (A & 0x0F) - (value & 0x0F) - borrow;
+        V = (((A ^ value) & (A ^ binary)) & 0x80) != 0;
+        C = binary >= 0;
+        if constexpr(Variant::CMOS){
+            int result = binary;
+            if(binary < 0){
+                result -= 0x60;
+            }
+            if(lo < 0){
+                result -= 0x06;
+            }
+            A = static_cast<u8>(result);
+            LDASetStatus();
+        }else{
+            int hi = (A >> 4) - (value >> 4);
+            if(lo < 0){
+                lo -= 0x06;
+                hi--;
+            }
+            if(hi < 0){
+                hi -= 0x06;
+            }
+            Z = (binary & 0xFF) == 0;
+            N = (binary & 0x80) != 0;
+            A = static_cast<u8>((hi << 4) | (lo & 0x0F));
+        }
+    }
+
+    // the 65C02 spends one more cycle fixing up the flags in decimal mode
+    constexpr void DecimalPenalty(int& cycles)
+    {
+        if constexpr(Variant::CMOS){
+            if(D){
+                cycles--;
             }
         }
-        return requestedCycles - cycles;
     }
+
+    constexpr void Compare(u8 reg, u8 value)
+    {
+        C = reg >= value;
+        SetZeroAndNegative(static_cast<u8>(reg - value));
+    }
+
+    constexpr u8 ShiftLeft(u8 value)
+    {
+        C = (value & 0x80) != 0;
+        value <<= 1;
+        SetZeroAndNegative(value);
+        return value;
+    }
+
+    constexpr u8 ShiftRight(u8 value)
+    {
+        C = value & 0x01;
+        value >>= 1;
+        SetZeroAndNegative(value);
+        return value;
+    }
+
+    constexpr u8 RotateLeft(u8 value)
+    {
+        u8 carry = C;
+        C = (value & 0x80) != 0;
+        value = (value << 1) | carry;
+        SetZeroAndNegative(value);
+        return value;
+    }
+
+    constexpr u8 RotateRight(u8 value)
+    {
+        u8 carry = C;
+        C = value & 0x01;
+        value = (value >> 1) | (carry << 7);
+        SetZeroAndNegative(value);
+        return value;
+    }
+
+    constexpr u8 Increment(u8 value)
+    {
+        value++;
+        SetZeroAndNegative(value);
+        return value;
+    }
+
+    constexpr u8 Decrement(u8 value)
+    {
+        value--;
+        SetZeroAndNegative(value);
+        return value;
+    }
+
+    constexpr u8 TestAndResetBits(u8 value)
+    {
+        Z = (A & value) == 0;
+        return value & ~A;
+    }
+
+    constexpr u8 TestAndSetBits(u8 value)
+    {
+        Z = (A & value) == 0;
+        return value | A;
+    }
+
+    template<u8 Bit>
+    constexpr u8 ResetMemoryBit(u8 value)
+    {
+        return value & ~(1 << Bit);
+    }
+
+    template<u8 Bit>
+    constexpr u8 SetMemoryBit(u8 value)
+    {
+        return value | (1 << Bit);
+    }
+
+    // undocumented read-modify-write combinations
+    constexpr u8 ShiftLeftOr(u8 value)
+    {
+        value = ShiftLeft(value);
+        A |= value;
+        LDASetStatus();
+        return value;
+    }
+
+    constexpr u8 RotateLeftAnd(u8 value)
+    {
+        value = RotateLeft(value);
+        A &= value;
+        LDASetStatus();
+        return value;
+    }
+
+    constexpr u8 ShiftRightEor(u8 value)
+    {
+        value = ShiftRight(value);
+        A ^= value;
+        LDASetStatus();
+        return value;
+    }
+
+    constexpr u8 RotateRightAdd(u8 value)
+    {
+        value = RotateRight(value);
+        AddWithCarry(value);
+        return value;
+    }
+
+    constexpr u8 DecrementCompare(u8 value)
+    {
+        value--;
+        Compare(A, value);
+        return value;
+    }
+
+    constexpr u8 IncrementSubtract(u8 value)
+    {
+        value++;
+        SubtractWithCarry(value);
+        return value;
+    }
+
+    // handlers
+    template<AddrMode Mode>
+    constexpr void ORA(MemType& mem, int& cycles)
+    {
+        A |= ReadOperand<Mode>(mem, cycles);
+        LDASetStatus();
+    }
+
+    template<AddrMode Mode>
+    constexpr void AND(MemType& mem, int& cycles)
+    {
+        A &= ReadOperand<Mode>(mem, cycles);
+        LDASetStatus();
+    }
+
+    template<AddrMode Mode>
+    constexpr void EOR(MemType& mem, int& cycles)
+    {
+        A ^= ReadOperand<Mode>(mem, cycles);
+        LDASetStatus();
+    }
+
+    template<AddrMode Mode>
+    constexpr void ADC(MemType& mem, int& cycles)
+    {
+        AddWithCarry(ReadOperand<Mode>(mem, cycles));
+        DecimalPenalty(cycles);
+    }
+
+    template<AddrMode Mode>
+    constexpr void SBC(MemType& mem, int& cycles)
+    {
+        SubtractWithCarry(ReadOperand<Mode>(mem, cycles));
+        DecimalPenalty(cycles);
+    }
+
+    template<AddrMode Mode>
+    constexpr void CMP(MemType& mem, int& cycles)
+    {
+        Compare(A, ReadOperand<Mode>(mem, cycles));
+    }
+
+    template<AddrMode Mode>
+    constexpr void CPX(MemType& mem, int& cycles)
+    {
+        Compare(X, ReadOperand<Mode>(mem, cycles));
+    }
+
+    template<AddrMode Mode>
+    constexpr void CPY(MemType& mem, int& cycles)
+    {
+        Compare(Y, ReadOperand<Mode>(mem, cycles));
+    }
+
+    template<AddrMode Mode>
+    constexpr void BIT(MemType& mem, int& cycles)
+    {
+        u8 value = ReadOperand<Mode>(mem, cycles);
+        Z = (A & value) == 0;
+        // BIT #imm on the 65C02 only touches Z
+        if constexpr(Mode != IM){
+            N = (value & NegativeFlagBit) != 0;
+            V = (value & OverflowFlagBit) != 0;
+        }
+    }
+
+    template<AddrMode Mode>
+    constexpr void LDA(MemType& mem, int& cycles)
+    {
+        A = ReadOperand<Mode>(mem, cycles);
+        LDASetStatus();
+    }
+
+    template<AddrMode Mode>
+    constexpr void LDX(MemType& mem, int& cycles)
+    {
+        X = ReadOperand<Mode>(mem, cycles);
+        LDXSetStatus();
+    }
+
+    template<AddrMode Mode>
+    constexpr void LDY(MemType& mem, int& cycles)
+    {
+        Y = ReadOperand<Mode>(mem, cycles);
+        LDYSetStatus();
+    }
+
+    template<AddrMode Mode>
+    constexpr void STA(MemType& mem, int& cycles)
+    {
+        WriteByte(A, Address<Mode, false>(mem, cycles), mem);
+    }
+
+    template<AddrMode Mode>
+    constexpr void STX(MemType& mem, int& cycles)
+    {
+        WriteByte(X, Address<Mode, false>(mem, cycles), mem);
+    }
+
+    template<AddrMode Mode>
+    constexpr void STY(MemType& mem, int& cycles)
+    {
+        WriteByte(Y, Address<Mode, false>(mem, cycles), mem);
+    }
+
+    template<AddrMode Mode>
+    constexpr void STZ(MemType& mem, int& cycles)
+    {
+        WriteByte(0, Address<Mode, false>(mem, cycles), mem);
+    }
+
+    template<AddrMode Mode, u8 (BasicCPU::*Operation)(u8), bool PagePenalty = false>
+    constexpr void ReadModifyWrite(MemType& mem, int& cycles)
+    {
+        u16 address = Address<Mode, PagePenalty>(mem, cycles);
+        WriteByte((this->*Operation)(ReadByte(address, mem)), address, mem);
+    }
+
+    template<u8 (BasicCPU::*Operation)(u8)>
+    constexpr void Accumulator(MemType& mem, int& cycles)
+    {
+        A = (this->*Operation)(A);
+    }
+
+    constexpr void INX(MemType& mem, int& cycles)
+    {
+        X = Increment(X);
+    }
+
+    constexpr void INY(MemType& mem, int& cycles)
+    {
+        Y = Increment(Y);
+    }
+
+    constexpr void DEX(MemType& mem, int& cycles)
+    {
+        X = Decrement(X);
+    }
+
+    constexpr void DEY(MemType& mem, int& cycles)
+    {
+        Y = Decrement(Y);
+    }
+
+    constexpr void TAX(MemType& mem, int& cycles)
+    {
+        X = A;
+        LDXSetStatus();
+    }
+
+    constexpr void TAY(MemType& mem, int& cycles)
+    {
+        Y = A;
+        LDYSetStatus();
+    }
+
+    constexpr void TXA(MemType& mem, int& cycles)
+    {
+        A = X;
+        LDASetStatus();
+    }
+
+    constexpr void TYA(MemType& mem, int& cycles)
+    {
+        A = Y;
+        LDASetStatus();
+    }
+
+    constexpr void TSX(MemType& mem, int& cycles)
+    {
+        X = SP;
+        LDXSetStatus();
+    }
+
+    constexpr void TXS(MemType& mem, int& cycles)
+    {
+        SP = X;
+    }
+
+    constexpr void PHA(MemType& mem, int& cycles)
+    {
+        PushByte(A, mem);
+    }
+
+    constexpr void PHX(MemType& mem, int& cycles)
+    {
+        PushByte(X, mem);
+    }
+
+    constexpr void PHY(MemType& mem, int& cycles)
+    {
+        PushByte(Y, mem);
+    }
+
+    constexpr void PHP(MemType& mem, int& cycles)
+    {
+        PushByte(GetStatus() | BreakFlagBit, mem);
+    }
+
+    constexpr void PLA(MemType& mem, int& cycles)
+    {
+        A = PopByte(mem);
+        LDASetStatus();
+    }
+
+    constexpr void PLX(MemType& mem, int& cycles)
+    {
+        X = PopByte(mem);
+        LDXSetStatus();
+    }
+
+    constexpr void PLY(MemType& mem, int& cycles)
+    {
+        Y = PopByte(mem);
+        LDYSetStatus();
+    }
+
+    constexpr void PLP(MemType& mem, int& cycles)
+    {
+        SetStatus(PopByte(mem));
+    }
+
+    constexpr void CLC(MemType& mem, int& cycles)
+    {
+        C = 0;
+    }
+
+    constexpr void SEC(MemType& mem, int& cycles)
+    {
+        C = 1;
+    }
+
+    constexpr void CLI(MemType& mem, int& cycles)
+    {
+        I = 0;
+    }
+
+    constexpr void SEI(MemType& mem, int& cycles)
+    {
+        I = 1;
+    }
+
+    constexpr void CLV(MemType& mem, int& cycles)
+    {
+        V = 0;
+    }
+
+    constexpr void CLD(MemType& mem, int& cycles)
+    {
+        D = 0;
+    }
+
+    constexpr void SED(MemType& mem, int& cycles)
+    {
+        D = 1;
+    }
+
+    // +1 cycle when taken, +1 more when the target is on another page
+    constexpr void Branch(bool condition, MemType& mem, int& cycles)
+    {
+        s8 offset = static_cast<s8>(FetchByte(mem));
+        if(condition){
+            cycles--;
+            u16 target = PC + offset;
+            if((target & 0xFF00) != (PC & 0xFF00)){
+                cycles--;
+            }
+            PC = target;
+        }
+    }
+
+    constexpr void BPL(MemType& mem, int& cycles)
+    {
+        Branch(!N, mem, cycles);
+    }
+
+    constexpr void BMI(MemType& mem, int& cycles)
+    {
+        Branch(N, mem, cycles);
+    }
+
+    constexpr void BVC(MemType& mem, int& cycles)
+    {
+        Branch(!V, mem, cycles);
+    }
+
+    constexpr void BVS(MemType& mem, int& cycles)
+    {
+        Branch(V, mem, cycles);
+    }
+
+    constexpr void BCC(MemType& mem, int& cycles)
+    {
+        Branch(!C, mem, cycles);
+    }
+
+    constexpr void BCS(MemType& mem, int& cycles)
+    {
+        Branch(C, mem, cycles);
+    }
+
+    constexpr void BNE(MemType& mem, int& cycles)
+    {
+        Branch(!Z, mem, cycles);
+    }
+
+    constexpr void BEQ(MemType& mem, int& cycles)
+    {
+        Branch(Z, mem, cycles);
+    }
+
+    constexpr void BRA(MemType& mem, int& cycles)
+    {
+        Branch(true, mem, cycles);
+    }
+
+    template<u8 Bit, bool Set>
+    constexpr void BranchOnBit(MemType& mem, int& cycles)
+    {
+        u8 value = ReadByteZPage(FetchByte(mem), mem);
+        Branch(((value >> Bit) & 1) == Set, mem, cycles);
+    }
+
+    constexpr void BRK(MemType& mem, int& cycles)
+    {
+        PC++;
+        PushWord(PC, mem);
+        PushByte(GetStatus() | BreakFlagBit, mem);
+        PC = ReadWord(0xFFFE, mem);
+        B = 1;
+        I = 1;
+        if constexpr(Variant::CMOS){
+            D = 0;
+        }
+    }
+
+    constexpr void JMP(MemType& mem, int& cycles)
+    {
+        PC = FetchWord(mem);
+    }
+
+    constexpr void JMPIndirect(MemType& mem, int& cycles)
+    {
+        u16 pointer = FetchWord(mem);
+        if constexpr(Variant::CMOS){
+            PC = ReadWord(pointer, mem);
+        }else{
+            // NMOS does not carry into the high byte of the pointer
+            u16 highAddress = (pointer & 0xFF00) | static_cast<u8>(pointer + 1);
+            PC = (ReadByte(highAddress, mem) << 8) | ReadByte(pointer, mem);
+        }
+    }
+
+    constexpr void JMPIndexedIndirect(MemType& mem, int& cycles)
+    {
+        PC = ReadWord(FetchWord(mem) + X, mem);
+    }
+
+    constexpr void JSR(MemType& mem, int& cycles)
+    {
+        u16 subAddr = FetchWord(mem);
+        PushWord(PC - 1, mem);
+        PC = subAddr;
+    }
+
+    constexpr void RTS(MemType& mem, int& cycles)
+    {
+        PC = PopWord(mem) + 1;
+    }
+
+    constexpr void RTI(MemType& mem, int& cycles)
+    {
+        SetStatus(PopByte(mem));
+        PC = PopWord(mem);
+    }
+
+    constexpr void NOP(MemType& mem, int& cycles)
+    {
+    }
+
+    // multi byte NOPs still perform the operand read
+    template<AddrMode Mode>
+    constexpr void NOPRead(MemType& mem, int& cycles)
+    {
+        ReadOperand<Mode>(mem, cycles);
+    }
+
+    template<AddrMode Mode>
+    constexpr void LAX(MemType& mem, int& cycles)
+    {
+        A = X = ReadOperand<Mode>(mem, cycles);
+        LDASetStatus();
+    }
+
+    template<AddrMode Mode>
+    constexpr void SAX(MemType& mem, int& cycles)
+    {
+        WriteByte(A & X, Address<Mode, false>(mem, cycles), mem);
+    }
+
+    constexpr void ANC(MemType& mem, int& cycles)
+    {
+        A &= FetchByte(mem);
+        LDASetStatus();
+        C = N;
+    }
+
+    constexpr void ALR(MemType& mem, int& cycles)
+    {
+        A = ShiftRight(A & FetchByte(mem));
+    }
+
+    constexpr void ARR(MemType& mem, int& cycles)
+    {
+        u8 value = A & FetchByte(mem);
+        u8 carry = C;
+        A = (value >> 1) | (carry << 7);
+        if(!D){
+            LDASetStatus();
+            C = (A & 0x40) != 0;
+            V = ((A >> 6) ^ (A >> 5)) & 0x01;
+            return;
+        }
+        N = carry;
+        Z = (A == 0);
+        V = ((value ^ A) & 0x40) != 0;
+        if((value & 0x0F) + (value & 0x01) > 0x05){
+            A = (A & 0xF0) | ((A + 0x06) & 0x0F);
+        }
+        C = (value & 0xF0) + (value & 0x10) > 0x50;
+        if(C){
+            A += 0x60;
+        }
+    }
+
+    constexpr void SBX(MemType& mem, int& cycles)
+    {
+        u8 value = FetchByte(mem);
+        u8 masked = A & X;
+        C = masked >= value;
+        X = masked - value;
+        LDXSetStatus();
+    }
+
+    constexpr void LAS(MemType& mem, int& cycles)
+    {
+        A = X = SP = ReadOperand<ABSY>(mem, cycles) & SP;
+        LDASetStatus();
+    }
+
+    constexpr void JAM(MemType& mem, int& cycles)
+    {
+        PC--;
+        Halted = true;
+        Leftover = cycles;
+        cycles = 0;
+    }
+
+    constexpr void STP(MemType& mem, int& cycles)
+    {
+        JAM(mem, cycles);
+    }
+
+    constexpr void WAI(MemType& mem, int& cycles)
+    {
+        PC--;
+        Waiting = true;
+        cycles = 0;
+    }
+
+    // halts with PC on the opcode, like JAM
+    constexpr void Unhandled(MemType& mem, int& cycles)
+    {
+        JAM(mem, cycles);
+    }
+
+    template<void (BasicCPU::*Operation)(MemType&, int&)>
+    static constexpr void Op(BasicCPU& cpu, MemType& mem, int& cycles)
+    {
+        (cpu.*Operation)(mem, cycles);
+    }
+
+    static constexpr void Set(OpTable& table, u8 opcode, Handler handler, u8 cycles)
+    {
+        table.Handlers[opcode] = handler;
+        table.Cycles[opcode] = cycles;
+    }
+
+    template<u8 Bit>
+    static constexpr void SetBitInstructions(OpTable& table)
+    {
+        Set(table, INS_RMB0 + (Bit << 4), Op<&BasicCPU::ReadModifyWrite<ZP, &BasicCPU::ResetMemoryBit<Bit>>>, 5);
+        Set(table, INS_SMB0 + (Bit << 4), Op<&BasicCPU::ReadModifyWrite<ZP, &BasicCPU::SetMemoryBit<Bit>>>, 5);
+        Set(table, INS_BBR0 + (Bit << 4), Op<&BasicCPU::BranchOnBit<Bit, false>>, 5);
+        Set(table, INS_BBS0 + (Bit << 4), Op<&BasicCPU::BranchOnBit<Bit, true>>, 5);
+        if constexpr(Bit < 7){
+            SetBitInstructions<Bit + 1>(table);
+        }
+    }
+
+    static constexpr OpTable BuildOpTable()
+    {
+        OpTable table{};
+        for(u32 i = 0; i < 256; i++){
+            Set(table, i, Op<&BasicCPU::Unhandled>, 1);
+        }
+
+        Set(table, INS_BRK, Op<&BasicCPU::BRK>, 7);
+
+        Set(table, INS_ORA_IM, Op<&BasicCPU::ORA<IM>>, 2);
+        Set(table, INS_ORA_ZP, Op<&BasicCPU::ORA<ZP>>, 3);
+        Set(table, INS_ORA_ZPX, Op<&BasicCPU::ORA<ZPX>>, 4);
+        Set(table, INS_ORA_ABS, Op<&BasicCPU::ORA<ABS>>, 4);
+        Set(table, INS_ORA_ABSX, Op<&BasicCPU::ORA<ABSX>>, 4);
+        Set(table, INS_ORA_ABSY, Op<&BasicCPU::ORA<ABSY>>, 4);
+        Set(table, INS_ORA_INDX, Op<&BasicCPU::ORA<INDX>>, 6);
+        Set(table, INS_ORA_INDY, Op<&BasicCPU::ORA<INDY>>, 5);
+
+        Set(table, INS_AND_IM, Op<&BasicCPU::AND<IM>>, 2);
+        Set(table, INS_AND_ZP, Op<&BasicCPU::AND<ZP>>, 3);
+        Set(table, INS_AND_ZPX, Op<&BasicCPU::AND<ZPX>>, 4);
+        Set(table, INS_AND_ABS, Op<&BasicCPU::AND<ABS>>, 4);
+        Set(table, INS_AND_ABSX, Op<&BasicCPU::AND<ABSX>>, 4);
+        Set(table, INS_AND_ABSY, Op<&BasicCPU::AND<ABSY>>, 4);
+        Set(table, INS_AND_INDX, Op<&BasicCPU::AND<INDX>>, 6);
+        Set(table, INS_AND_INDY, Op<&BasicCPU::AND<INDY>>, 5);
+
+        Set(table, INS_EOR_IM, Op<&BasicCPU::EOR<IM>>, 2);
+        Set(table, INS_EOR_ZP, Op<&BasicCPU::EOR<ZP>>, 3);
+        Set(table, INS_EOR_ZPX, Op<&BasicCPU::EOR<ZPX>>, 4);
+        Set(table, INS_EOR_ABS, Op<&BasicCPU::EOR<ABS>>, 4);
+        Set(table, INS_EOR_ABSX, Op<&BasicCPU::EOR<ABSX>>, 4);
+        Set(table, INS_EOR_ABSY, Op<&BasicCPU::EOR<ABSY>>, 4);
+        Set(table, INS_EOR_INDX, Op<&BasicCPU::EOR<INDX>>, 6);
+        Set(table, INS_EOR_INDY, Op<&BasicCPU::EOR<INDY>>, 5);
+
+        Set(table, INS_ADC_IM, Op<&BasicCPU::ADC<IM>>, 2);
+        Set(table, INS_ADC_ZP, Op<&BasicCPU::ADC<ZP>>, 3);
+        Set(table, INS_ADC_ZPX, Op<&BasicCPU::ADC<ZPX>>, 4);
+        Set(table, INS_ADC_ABS, Op<&BasicCPU::ADC<ABS>>, 4);
+        Set(table, INS_ADC_ABSX, Op<&BasicCPU::ADC<ABSX>>, 4);
+        Set(table, INS_ADC_ABSY, Op<&BasicCPU::ADC<ABSY>>, 4);
+        Set(table, INS_ADC_INDX, Op<&BasicCPU::ADC<INDX>>, 6);
+        Set(table, INS_ADC_INDY, Op<&BasicCPU::ADC<INDY>>, 5);
+
+        Set(table, INS_SBC_IM, Op<&BasicCPU::SBC<IM>>, 2);
+        Set(table, INS_SBC_ZP, Op<&BasicCPU::SBC<ZP>>, 3);
+        Set(table, INS_SBC_ZPX, Op<&BasicCPU::SBC<ZPX>>, 4);
+        Set(table, INS_SBC_ABS, Op<&BasicCPU::SBC<ABS>>, 4);
+        Set(table, INS_SBC_ABSX, Op<&BasicCPU::SBC<ABSX>>, 4);
+        Set(table, INS_SBC_ABSY, Op<&BasicCPU::SBC<ABSY>>, 4);
+        Set(table, INS_SBC_INDX, Op<&BasicCPU::SBC<INDX>>, 6);
+        Set(table, INS_SBC_INDY, Op<&BasicCPU::SBC<INDY>>, 5);
+
+        Set(table, INS_CMP_IM, Op<&BasicCPU::CMP<IM>>, 2);
+        Set(table, INS_CMP_ZP, Op<&BasicCPU::CMP<ZP>>, 3);
+        Set(table, INS_CMP_ZPX, Op<&BasicCPU::CMP<ZPX>>, 4);
+        Set(table, INS_CMP_ABS, Op<&BasicCPU::CMP<ABS>>, 4);
+        Set(table, INS_CMP_ABSX, Op<&BasicCPU::CMP<ABSX>>, 4);
+        Set(table, INS_CMP_ABSY, Op<&BasicCPU::CMP<ABSY>>, 4);
+        Set(table, INS_CMP_INDX, Op<&BasicCPU::CMP<INDX>>, 6);
+        Set(table, INS_CMP_INDY, Op<&BasicCPU::CMP<INDY>>, 5);
+
+        Set(table, INS_CPX_IM, Op<&BasicCPU::CPX<IM>>, 2);
+        Set(table, INS_CPX_ZP, Op<&BasicCPU::CPX<ZP>>, 3);
+        Set(table, INS_CPX_ABS, Op<&BasicCPU::CPX<ABS>>, 4);
+        Set(table, INS_CPY_IM, Op<&BasicCPU::CPY<IM>>, 2);
+        Set(table, INS_CPY_ZP, Op<&BasicCPU::CPY<ZP>>, 3);
+        Set(table, INS_CPY_ABS, Op<&BasicCPU::CPY<ABS>>, 4);
+
+        Set(table, INS_BIT_ZP, Op<&BasicCPU::BIT<ZP>>, 3);
+        Set(table, INS_BIT_ABS, Op<&BasicCPU::BIT<ABS>>, 4);
+
+        Set(table, INS_LDA_IM, Op<&BasicCPU::LDA<IM>>, 2);
+        Set(table, INS_LDA_ZP, Op<&BasicCPU::LDA<ZP>>, 3);
+        Set(table, INS_LDA_ZPX, Op<&BasicCPU::LDA<ZPX>>, 4);
+        Set(table, INS_LDA_ABS, Op<&BasicCPU::LDA<ABS>>, 4);
+        Set(table, INS_LDA_ABSX, Op<&BasicCPU::LDA<ABSX>>, 4);
+        Set(table, INS_LDA_ABSY, Op<&BasicCPU::LDA<ABSY>>, 4);
+        Set(table, INS_LDA_INDX, Op<&BasicCPU::LDA<INDX>>, 6);
+        Set(table, INS_LDA_INDY, Op<&BasicCPU::LDA<INDY>>, 5);
+
+        Set(table, INS_LDX_IM, Op<&BasicCPU::LDX<IM>>, 2);
+        Set(table, INS_LDX_ZP, Op<&BasicCPU::LDX<ZP>>, 3);
+        Set(table, INS_LDX_ZPY, Op<&BasicCPU::LDX<ZPY>>, 4);
+        Set(table, INS_LDX_ABS, Op<&BasicCPU::LDX<ABS>>, 4);
+        Set(table, INS_LDX_ABSY, Op<&BasicCPU::LDX<ABSY>>, 4);
+
+        Set(table, INS_LDY_IM, Op<&BasicCPU::LDY<IM>>, 2);
+        Set(table, INS_LDY_ZP, Op<&BasicCPU::LDY<ZP>>, 3);
+        Set(table, INS_LDY_ZPX, Op<&BasicCPU::LDY<ZPX>>, 4);
+        Set(table, INS_LDY_ABS, Op<&BasicCPU::LDY<ABS>>, 4);
+        Set(table, INS_LDY_ABSX, Op<&BasicCPU::LDY<ABSX>>, 4);
+
+        Set(table, INS_STA_ZP, Op<&BasicCPU::STA<ZP>>, 3);
+        Set(table, INS_STA_ZPX, Op<&BasicCPU::STA<ZPX>>, 4);
+        Set(table, INS_STA_ABS, Op<&BasicCPU::STA<ABS>>, 4);
+        Set(table, INS_STA_ABSX, Op<&BasicCPU::STA<ABSX>>, 5);
+        Set(table, INS_STA_ABSY, Op<&BasicCPU::STA<ABSY>>, 5);
+        Set(table, INS_STA_INDX, Op<&BasicCPU::STA<INDX>>, 6);
+        Set(table, INS_STA_INDY, Op<&BasicCPU::STA<INDY>>, 6);
+
+        Set(table, INS_STX_ZP, Op<&BasicCPU::STX<ZP>>, 3);
+        Set(table, INS_STX_ZPY, Op<&BasicCPU::STX<ZPY>>, 4);
+        Set(table, INS_STX_ABS, Op<&BasicCPU::STX<ABS>>, 4);
+        Set(table, INS_STY_ZP, Op<&BasicCPU::STY<ZP>>, 3);
+        Set(table, INS_STY_ZPX, Op<&BasicCPU::STY<ZPX>>, 4);
+        Set(table, INS_STY_ABS, Op<&BasicCPU::STY<ABS>>, 4);
+
+        Set(table, INS_ASL_ACC, Op<&BasicCPU::Accumulator<&BasicCPU::ShiftLeft>>, 2);
+        Set(table, INS_ASL_ZP, Op<&BasicCPU::ReadModifyWrite<ZP, &BasicCPU::ShiftLeft>>, 5);
+        Set(table, INS_ASL_ZPX, Op<&BasicCPU::ReadModifyWrite<ZPX, &BasicCPU::ShiftLeft>>, 6);
+        Set(table, INS_ASL_ABS, Op<&BasicCPU::ReadModifyWrite<ABS, &BasicCPU::ShiftLeft>>, 6);
+        Set(table, INS_LSR_ACC, Op<&BasicCPU::Accumulator<&BasicCPU::ShiftRight>>, 2);
+        Set(table, INS_LSR_ZP, Op<&BasicCPU::ReadModifyWrite<ZP, &BasicCPU::ShiftRight>>, 5);
+        Set(table, INS_LSR_ZPX, Op<&BasicCPU::ReadModifyWrite<ZPX, &BasicCPU::ShiftRight>>, 6);
+        Set(table, INS_LSR_ABS, Op<&BasicCPU::ReadModifyWrite<ABS, &BasicCPU::ShiftRight>>, 6);
+        Set(table, INS_ROL_ACC, Op<&BasicCPU::Accumulator<&BasicCPU::RotateLeft>>, 2);
+        Set(table, INS_ROL_ZP, Op<&BasicCPU::ReadModifyWrite<ZP, &BasicCPU::RotateLeft>>, 5);
+        Set(table, INS_ROL_ZPX, Op<&BasicCPU::ReadModifyWrite<ZPX, &BasicCPU::RotateLeft>>, 6);
+        Set(table, INS_ROL_ABS, Op<&BasicCPU::ReadModifyWrite<ABS, &BasicCPU::RotateLeft>>, 6);
+        Set(table, INS_ROR_ACC, Op<&BasicCPU::Accumulator<&BasicCPU::RotateRight>>, 2);
+        Set(table, INS_ROR_ZP, Op<&BasicCPU::ReadModifyWrite<ZP, &BasicCPU::RotateRight>>, 5);
+        Set(table, INS_ROR_ZPX, Op<&BasicCPU::ReadModifyWrite<ZPX, &BasicCPU::RotateRight>>, 6);
+        Set(table, INS_ROR_ABS, Op<&BasicCPU::ReadModifyWrite<ABS, &BasicCPU::RotateRight>>, 6);
+
+        Set(table, INS_INC_ZP, Op<&BasicCPU::ReadModifyWrite<ZP, &BasicCPU::Increment>>, 5);
+        Set(table, INS_INC_ZPX, Op<&BasicCPU::ReadModifyWrite<ZPX, &BasicCPU::Increment>>, 6);
+        Set(table, INS_INC_ABS, Op<&BasicCPU::ReadModifyWrite<ABS, &BasicCPU::Increment>>, 6);
+        Set(table, INS_INC_ABSX, Op<&BasicCPU::ReadModifyWrite<ABSX, &BasicCPU::Increment>>, 7);
+        Set(table, INS_DEC_ZP, Op<&BasicCPU::ReadModifyWrite<ZP, &BasicCPU::Decrement>>, 5);
+        Set(table, INS_DEC_ZPX, Op<&BasicCPU::ReadModifyWrite<ZPX, &BasicCPU::Decrement>>, 6);
+        Set(table, INS_DEC_ABS, Op<&BasicCPU::ReadModifyWrite<ABS, &BasicCPU::Decrement>>, 6);
+        Set(table, INS_DEC_ABSX, Op<&BasicCPU::ReadModifyWrite<ABSX, &BasicCPU::Decrement>>, 7);
+
+        Set(table, INS_INX, Op<&BasicCPU::INX>, 2);
+        Set(table, INS_INY, Op<&BasicCPU::INY>, 2);
+        Set(table, INS_DEX, Op<&BasicCPU::DEX>, 2);
+        Set(table, INS_DEY, Op<&BasicCPU::DEY>, 2);
+
+        Set(table, INS_TAX, Op<&BasicCPU::TAX>, 2);
+        Set(table, INS_TAY, Op<&BasicCPU::TAY>, 2);
+        Set(table, INS_TXA, Op<&BasicCPU::TXA>, 2);
+        Set(table, INS_TYA, Op<&BasicCPU::TYA>, 2);
+        Set(table, INS_TSX, Op<&BasicCPU::TSX>, 2);
+        Set(table, INS_TXS, Op<&BasicCPU::TXS>, 2);
+
+        Set(table, INS_PHA, Op<&BasicCPU::PHA>, 3);
+        Set(table, INS_PHP, Op<&BasicCPU::PHP>, 3);
+        Set(table, INS_PLA, Op<&BasicCPU::PLA>, 4);
+        Set(table, INS_PLP, Op<&BasicCPU::PLP>, 4);
+
+        Set(table, INS_CLC, Op<&BasicCPU::CLC>, 2);
+        Set(table, INS_SEC, Op<&BasicCPU::SEC>, 2);
+        Set(table, INS_CLI, Op<&BasicCPU::CLI>, 2);
+        Set(table, INS_SEI, Op<&BasicCPU::SEI>, 2);
+        Set(table, INS_CLV, Op<&BasicCPU::CLV>, 2);
+        Set(table, INS_CLD, Op<&BasicCPU::CLD>, 2);
+        Set(table, INS_SED, Op<&BasicCPU::SED>, 2);
+
+        Set(table, INS_BPL, Op<&BasicCPU::BPL>, 2);
+        Set(table, INS_BMI, Op<&BasicCPU::BMI>, 2);
+        Set(table, INS_BVC, Op<&BasicCPU::BVC>, 2);
+        Set(table, INS_BVS, Op<&BasicCPU::BVS>, 2);
+        Set(table, INS_BCC, Op<&BasicCPU::BCC>, 2);
+        Set(table, INS_BCS, Op<&BasicCPU::BCS>, 2);
+        Set(table, INS_BNE, Op<&BasicCPU::BNE>, 2);
+        Set(table, INS_BEQ, Op<&BasicCPU::BEQ>, 2);
+
+        Set(table, INS_JMP_ABS, Op<&BasicCPU::JMP>, 3);
+        Set(table, INS_JSR, Op<&BasicCPU::JSR>, 6);
+        Set(table, INS_RTS, Op<&BasicCPU::RTS>, 6);
+        Set(table, INS_RTI, Op<&BasicCPU::RTI>, 6);
+        Set(table, INS_NOP, Op<&BasicCPU::NOP>, 2);
+
+        if constexpr(Variant::CMOS){
+            BuildCMOSOpcodes(table);
+        }else{
+            BuildNMOSOpcodes(table);
+        }
+        return table;
+    }
+
+    static constexpr void BuildNMOSOpcodes(OpTable& table)
+    {
+        Set(table, INS_ASL_ABSX, Op<&BasicCPU::ReadModifyWrite<ABSX, &BasicCPU::ShiftLeft>>, 7);
+        Set(table, INS_LSR_ABSX, Op<&BasicCPU::ReadModifyWrite<ABSX, &BasicCPU::ShiftRight>>, 7);
+        Set(table, INS_ROL_ABSX, Op<&BasicCPU::ReadModifyWrite<ABSX, &BasicCPU::RotateLeft>>, 7);
+        Set(table, INS_ROR_ABSX, Op<&BasicCPU::ReadModifyWrite<ABSX, &BasicCPU::RotateRight>>, 7);
+        Set(table, INS_JMP_IND, Op<&BasicCPU::JMPIndirect>, 5);
+
+        Set(table, INS_SLO_ZP, Op<&BasicCPU::ReadModifyWrite<ZP, &BasicCPU::ShiftLeftOr>>, 5);
+        Set(table, INS_SLO_ZPX, Op<&BasicCPU::ReadModifyWrite<ZPX, &BasicCPU::ShiftLeftOr>>, 6);
+        Set(table, INS_SLO_ABS, Op<&BasicCPU::ReadModifyWrite<ABS, &BasicCPU::ShiftLeftOr>>, 6);
+        Set(table, INS_SLO_ABSX, Op<&BasicCPU::ReadModifyWrite<ABSX, &BasicCPU::ShiftLeftOr>>, 7);
+        Set(table, INS_SLO_ABSY, Op<&BasicCPU::ReadModifyWrite<ABSY, &BasicCPU::ShiftLeftOr>>, 7);
+        Set(table, INS_SLO_INDX, Op<&BasicCPU::ReadModifyWrite<INDX, &BasicCPU::ShiftLeftOr>>, 8);
+        Set(table, INS_SLO_INDY, Op<&BasicCPU::ReadModifyWrite<INDY, &BasicCPU::ShiftLeftOr>>, 8);
+
+        Set(table, INS_RLA_ZP, Op<&BasicCPU::ReadModifyWrite<ZP, &BasicCPU::RotateLeftAnd>>, 5);
+        Set(table, INS_RLA_ZPX, Op<&BasicCPU::ReadModifyWrite<ZPX, &BasicCPU::RotateLeftAnd>>, 6);
+        Set(table, INS_RLA_ABS, Op<&BasicCPU::ReadModifyWrite<ABS, &BasicCPU::RotateLeftAnd>>, 6);
+        Set(table, INS_RLA_ABSX, Op<&BasicCPU::ReadModifyWrite<ABSX, &BasicCPU::RotateLeftAnd>>, 7);
+        Set(table, INS_RLA_ABSY, Op<&BasicCPU::ReadModifyWrite<ABSY, &BasicCPU::RotateLeftAnd>>, 7);
+        Set(table, INS_RLA_INDX, Op<&BasicCPU::ReadModifyWrite<INDX, &BasicCPU::RotateLeftAnd>>, 8);
+        Set(table, INS_RLA_INDY, Op<&BasicCPU::ReadModifyWrite<INDY, &BasicCPU::RotateLeftAnd>>, 8);
+
+        Set(table, INS_SRE_ZP, Op<&BasicCPU::ReadModifyWrite<ZP, &BasicCPU::ShiftRightEor>>, 5);
+        Set(table, INS_SRE_ZPX, Op<&BasicCPU::ReadModifyWrite<ZPX, &BasicCPU::ShiftRightEor>>, 6);
+        Set(table, INS_SRE_ABS, Op<&BasicCPU::ReadModifyWrite<ABS, &BasicCPU::ShiftRightEor>>, 6);
+        Set(table, INS_SRE_ABSX, Op<&BasicCPU::ReadModifyWrite<ABSX, &BasicCPU::ShiftRightEor>>, 7);
+        Set(table, INS_SRE_ABSY, Op<&BasicCPU::ReadModifyWrite<ABSY, &BasicCPU::ShiftRightEor>>, 7);
+        Set(table, INS_SRE_INDX, Op<&BasicCPU::ReadModifyWrite<INDX, &BasicCPU::ShiftRightEor>>, 8);
+        Set(table, INS_SRE_INDY, Op<&BasicCPU::ReadModifyWrite<INDY, &BasicCPU::ShiftRightEor>>, 8);
+
+        Set(table, INS_RRA_ZP, Op<&BasicCPU::ReadModifyWrite<ZP, &BasicCPU::RotateRightAdd>>, 5);
+        Set(table, INS_RRA_ZPX, Op<&BasicCPU::ReadModifyWrite<ZPX, &BasicCPU::RotateRightAdd>>, 6);
+        Set(table, INS_RRA_ABS, Op<&BasicCPU::ReadModifyWrite<ABS, &BasicCPU::RotateRightAdd>>, 6);
+        Set(table, INS_RRA_ABSX, Op<&BasicCPU::ReadModifyWrite<ABSX, &BasicCPU::RotateRightAdd>>, 7);
+        Set(table, INS_RRA_ABSY, Op<&BasicCPU::ReadModifyWrite<ABSY, &BasicCPU::RotateRightAdd>>, 7);
+        Set(table, INS_RRA_INDX, Op<&BasicCPU::ReadModifyWrite<INDX, &BasicCPU::RotateRightAdd>>, 8);
+        Set(table, INS_RRA_INDY, Op<&BasicCPU::ReadModifyWrite<INDY, &BasicCPU::RotateRightAdd>>, 8);
+
+        Set(table, INS_DCP_ZP, Op<&BasicCPU::ReadModifyWrite<ZP, &BasicCPU::DecrementCompare>>, 5);
+        Set(table, INS_DCP_ZPX, Op<&BasicCPU::ReadModifyWrite<ZPX, &BasicCPU::DecrementCompare>>, 6);
+        Set(table, INS_DCP_ABS, Op<&BasicCPU::ReadModifyWrite<ABS, &BasicCPU::DecrementCompare>>, 6);
+        Set(table, INS_DCP_ABSX, Op<&BasicCPU::ReadModifyWrite<ABSX, &BasicCPU::DecrementCompare>>, 7);
+        Set(table, INS_DCP_ABSY, Op<&BasicCPU::ReadModifyWrite<ABSY, &BasicCPU::DecrementCompare>>, 7);
+        Set(table, INS_DCP_INDX, Op<&BasicCPU::ReadModifyWrite<INDX, &BasicCPU::DecrementCompare>>, 8);
+        Set(table, INS_DCP_INDY, Op<&BasicCPU::ReadModifyWrite<INDY, &BasicCPU::DecrementCompare>>, 8);
+
+        Set(table, INS_ISC_ZP, Op<&BasicCPU::ReadModifyWrite<ZP, &BasicCPU::IncrementSubtract>>, 5);
+        Set(table, INS_ISC_ZPX, Op<&BasicCPU::ReadModifyWrite<ZPX, &BasicCPU::IncrementSubtract>>, 6);
+        Set(table, INS_ISC_ABS, Op<&BasicCPU::ReadModifyWrite<ABS, &BasicCPU::IncrementSubtract>>, 6);
+        Set(table, INS_ISC_ABSX, Op<&BasicCPU::ReadModifyWrite<ABSX, &BasicCPU::IncrementSubtract>>, 7);
+        Set(table, INS_ISC_ABSY, Op<&BasicCPU::ReadModifyWrite<ABSY, &BasicCPU::IncrementSubtract>>, 7);
+        Set(table, INS_ISC_INDX, Op<&BasicCPU::ReadModifyWrite<INDX, &BasicCPU::IncrementSubtract>>, 8);
+        Set(table, INS_ISC_INDY, Op<&BasicCPU::ReadModifyWrite<INDY, &BasicCPU::IncrementSubtract>>, 8);
+
+        Set(table, INS_SAX_ZP, Op<&BasicCPU::SAX<ZP>>, 3);
+        Set(table, INS_SAX_ZPY, Op<&BasicCPU::SAX<ZPY>>, 4);
+        Set(table, INS_SAX_ABS, Op<&BasicCPU::SAX<ABS>>, 4);
+        Set(table, INS_SAX_INDX, Op<&BasicCPU::SAX<INDX>>, 6);
+
+        Set(table, INS_LAX_ZP, Op<&BasicCPU::LAX<ZP>>, 3);
+        Set(table, INS_LAX_ZPY, Op<&BasicCPU::LAX<ZPY>>, 4);
+        Set(table, INS_LAX_ABS, Op<&BasicCPU::LAX<ABS>>, 4);
+        Set(table, INS_LAX_ABSY, Op<&BasicCPU::LAX<ABSY>>, 4);
+        Set(table, INS_LAX_INDX, Op<&BasicCPU::LAX<INDX>>, 6);
+        Set(table, INS_LAX_INDY, Op<&BasicCPU::LAX<INDY>>, 5);
+
+        Set(table, INS_ANC_IM, Op<&BasicCPU::ANC>, 2);
+        Set(table, 0x2B, Op<&BasicCPU::ANC>, 2);
+        Set(table, INS_ALR_IM, Op<&BasicCPU::ALR>, 2);
+        Set(table, INS_ARR_IM, Op<&BasicCPU::ARR>, 2);
+        Set(table, INS_SBX_IM, Op<&BasicCPU::SBX>, 2);
+        Set(table, 0xEB, Op<&BasicCPU::SBC<IM>>, 2);
+        Set(table, INS_LAS_ABSY, Op<&BasicCPU::LAS>, 4);
+
+        constexpr u8 impliedNOPs[] = {0x1A, 0x3A, 0x5A, 0x7A, 0xDA, 0xFA};
+        for(u8 opcode : impliedNOPs){
+            Set(table, opcode, Op<&BasicCPU::NOP>, 2);
+        }
+        constexpr u8 immediateNOPs[] = {0x80, 0x82, 0x89, 0xC2, 0xE2};
+        for(u8 opcode : immediateNOPs){
+            Set(table, opcode, Op<&BasicCPU::NOPRead<IM>>, 2);
+        }
+        constexpr u8 zeroPageNOPs[] = {0x04, 0x44, 0x64};
+        for(u8 opcode : zeroPageNOPs){
+            Set(table, opcode, Op<&BasicCPU::NOPRead<ZP>>, 3);
+        }
+        constexpr u8 zeroPageXNOPs[] = {0x14, 0x34, 0x54, 0x74, 0xD4, 0xF4};
+        for(u8 opcode : zeroPageXNOPs){
+            Set(table, opcode, Op<&BasicCPU::NOPRead<ZPX>>, 4);
+        }
+        Set(table, 0x0C, Op<&BasicCPU::NOPRead<ABS>>, 4);
+        constexpr u8 absoluteXNOPs[] = {0x1C, 0x3C, 0x5C, 0x7C, 0xDC, 0xFC};
+        for(u8 opcode : absoluteXNOPs){
+            Set(table, opcode, Op<&BasicCPU::NOPRead<ABSX>>, 4);
+        }
+
+        constexpr u8 jams[] = {0x02, 0x12, 0x22, 0x32, 0x42, 0x52, 0x62, 0x72, 0x92, 0xB2, 0xD2, 0xF2};
+        for(u8 opcode : jams){
+            Set(table, opcode, Op<&BasicCPU::JAM>, 1);
+        }
+    }
+
+    static constexpr void BuildCMOSOpcodes(OpTable& table)
+    {
+        // every undefined opcode is a NOP on the 65C02
+        for(u32 i = 0; i < 256; i++){
+            if((i & 0x0F) == 0x03 || (i & 0x0F) == 0x0B){
+                Set(table, i, Op<&BasicCPU::NOP>, 1);
+            }
+        }
+        constexpr u8 immediateNOPs[] = {0x02, 0x22, 0x42, 0x62, 0x82, 0xC2, 0xE2};
+        for(u8 opcode : immediateNOPs){
+            Set(table, opcode, Op<&BasicCPU::NOPRead<IM>>, 2);
+        }
+        Set(table, 0x44, Op<&BasicCPU::NOPRead<ZP>>, 3);
+        Set(table, 0x54, Op<&BasicCPU::NOPRead<ZPX>>, 4);
+        Set(table, 0xD4, Op<&BasicCPU::NOPRead<ZPX>>, 4);
+        Set(table, 0xF4, Op<&BasicCPU::NOPRead<ZPX>>, 4);
+        Set(table, 0x5C, Op<&BasicCPU::NOPRead<ABS>>, 8);
+        Set(table, 0xDC, Op<&BasicCPU::NOPRead<ABS>>, 4);
+        Set(table, 0xFC, Op<&BasicCPU::NOPRead<ABS>>, 4);
+
+        Set(table, INS_ASL_ABSX, Op<&BasicCPU::ReadModifyWrite<ABSX, &BasicCPU::ShiftLeft, true>>, 6);
+        Set(table, INS_LSR_ABSX, Op<&BasicCPU::ReadModifyWrite<ABSX, &BasicCPU::ShiftRight, true>>, 6);
+        Set(table, INS_ROL_ABSX, Op<&BasicCPU::ReadModifyWrite<ABSX, &BasicCPU::RotateLeft, true>>, 6);
+        Set(table, INS_ROR_ABSX, Op<&BasicCPU::ReadModifyWrite<ABSX, &BasicCPU::RotateRight, true>>, 6);
+        Set(table, INS_JMP_IND, Op<&BasicCPU::JMPIndirect>, 6);
+        Set(table, INS_JMP_ABSXI, Op<&BasicCPU::JMPIndexedIndirect>, 6);
+
+        Set(table, INS_BRA, Op<&BasicCPU::BRA>, 2);
+        Set(table, INS_PHX, Op<&BasicCPU::PHX>, 3);
+        Set(table, INS_PHY, Op<&BasicCPU::PHY>, 3);
+        Set(table, INS_PLX, Op<&BasicCPU::PLX>, 4);
+        Set(table, INS_PLY, Op<&BasicCPU::PLY>, 4);
+
+        Set(table, INS_STZ_ZP, Op<&BasicCPU::STZ<ZP>>, 3);
+        Set(table, INS_STZ_ZPX, Op<&BasicCPU::STZ<ZPX>>, 4);
+        Set(table, INS_STZ_ABS, Op<&BasicCPU::STZ<ABS>>, 4);
+        Set(table, INS_STZ_ABSX, Op<&BasicCPU::STZ<ABSX>>, 5);
+
+        Set(table, INS_TRB_ZP, Op<&BasicCPU::ReadModifyWrite<ZP, &BasicCPU::TestAndResetBits>>, 5);
+        Set(table, INS_TRB_ABS, Op<&BasicCPU::ReadModifyWrite<ABS, &BasicCPU::TestAndResetBits>>, 6);
+        Set(table, INS_TSB_ZP, Op<&BasicCPU::ReadModifyWrite<ZP, &BasicCPU::TestAndSetBits>>, 5);
+        Set(table, INS_TSB_ABS, Op<&BasicCPU::ReadModifyWrite<ABS, &BasicCPU::TestAndSetBits>>, 6);
+
+        Set(table, INS_BIT_IM, Op<&BasicCPU::BIT<IM>>, 2);
+        Set(table, INS_BIT_ZPX, Op<&BasicCPU::BIT<ZPX>>, 4);
+        Set(table, INS_BIT_ABSX, Op<&BasicCPU::BIT<ABSX>>, 4);
+        Set(table, INS_INC_ACC, Op<&BasicCPU::Accumulator<&BasicCPU::Increment>>, 2);
+        Set(table, INS_DEC_ACC, Op<&BasicCPU::Accumulator<&BasicCPU::Decrement>>, 2);
+
+        Set(table, INS_ORA_ZPI, Op<&BasicCPU::ORA<ZPI>>, 5);
+        Set(table, INS_AND_ZPI, Op<&BasicCPU::AND<ZPI>>, 5);
+        Set(table, INS_EOR_ZPI, Op<&BasicCPU::EOR<ZPI>>, 5);
+        Set(table, INS_ADC_ZPI, Op<&BasicCPU::ADC<ZPI>>, 5);
+        Set(table, INS_STA_ZPI, Op<&BasicCPU::STA<ZPI>>, 5);
+        Set(table, INS_LDA_ZPI, Op<&BasicCPU::LDA<ZPI>>, 5);
+        Set(table, INS_CMP_ZPI, Op<&BasicCPU::CMP<ZPI>>, 5);
+        Set(table, INS_SBC_ZPI, Op<&BasicCPU::SBC<ZPI>>, 5);
+
+        SetBitInstructions<0>(table);
+
+        Set(table, INS_WAI, Op<&BasicCPU::WAI>, 3);
+        Set(table, INS_STP, Op<&BasicCPU::STP>, 3);
+    }
+
+    // Runs at least cycles and returns the cycles used, less when the CPU
+    // halts. A CPU in WAI idles through the rest of them.
+    constexpr int Execute(int cycles, MemType& mem)
+    {
+        return Execute(OpcodeTable<BasicCPU>::Table, cycles, mem);
+    }
+
+    // runs against another table built from this one, see M6502Fusion.h
+    constexpr int Execute(const OpTable& ops, int cycles, MemType& mem)
+    {
+        int requestedCycles = cycles;
+        while(cycles > 0){
+            u8 ins = FetchByte(mem);
+            cycles -= ops.Cycles[ins];
+            ops.Handlers[ins](*this, mem, cycles);
+        }
+        return Used(requestedCycles, cycles);
+    }
+
+    // for loops like Execute's, the cycles used without what a halt left
+    // unused
+    constexpr int Used(int requestedCycles, int cycles)
+    {
+        int used = requestedCycles - cycles - Leftover;
+        Leftover = 0;
+        return used;
+    }
+};
+
+template<typename CPUType>
+struct M6502::OpcodeTable{
+    static constexpr typename CPUType::OpTable Table = CPUType::BuildOpTable();
 };
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,166 @@
+// Explores every input of a small routine and reports how fast and how
+// compactly the states were explored.
+//
+// usage: explore [-j threads] [-c step cycles] [-m max visited in memory] [routine]
+//
+// The routines are an 8x8 bit multiply over both 8 bit inputs and a 16 bit
+// CRC over three input bytes, the multiply by default. The result of every
+// final state is checked against the same computation done on the host.
+#include <memory>
+#include <string>
+#include "M6502Explore.h"
+
+using namespace M6502;
+
+namespace
+{
+    // 16 bit product of $80 and $81 to $82/$83, the inputs stay
+    constexpr u8 MultiplyProgram[] = {
+        0xA5, 0x80,         // 0200 LDA $80
+        0x85, 0x84,         // 0202 STA $84
+        0xA9, 0x00,         // 0204 LDA #$00
+        0x85, 0x85,         // 0206 STA $85
+        0x85, 0x82,         // 0208 STA $82
+        0x85, 0x83,         // 020A STA $83
+        0xA5, 0x81,         // 020C LDA $81
+        0x85, 0x86,         // 020E STA $86
+        // loop
+        0x46, 0x86,         // 0210 LSR $86
+        0x90, 0x0D,         // 0212 BCC $0221
+        0x18,               // 0214 CLC
+        0xA5, 0x82,         // 0215 LDA $82
+        0x65, 0x84,         // 0217 ADC $84
+        0x85, 0x82,         // 0219 STA $82
+        0xA5, 0x83,         // 021B LDA $83
+        0x65, 0x85,         // 021D ADC $85
+        0x85, 0x83,         // 021F STA $83
+        // skip
+        0x06, 0x84,         // 0221 ASL $84
+        0x26, 0x85,         // 0223 ROL $85
+        0xA5, 0x86,         // 0225 LDA $86
+        0xD0, 0xE7,         // 0227 BNE $0210
+        0x02,               // 0229 JAM
+    };
+
+    // CRC-16/XMODEM of the 3 bytes at $80 to $84/$85 (high/low), the
+    // inputs are shifted out
+    constexpr u8 CRC16Program[] = {
+        0xA9, 0x00,         // 0200 LDA #$00
+        0x85, 0x84,         // 0202 STA $84
+        0x85, 0x85,         // 0204 STA $85
+        0xA0, 0x00,         // 0206 LDY #$00
+        // byte
+        0xB9, 0x80, 0x00,   // 0208 LDA $0080,Y
+        0x45, 0x84,         // 020B EOR $84
+        0x85, 0x84,         // 020D STA $84
+        0xA9, 0x00,         // 020F LDA #$00
+        0x99, 0x80, 0x00,   // 0211 STA $0080,Y
+        0xA2, 0x08,         // 0214 LDX #$08
+        // bit
+        0x06, 0x85,         // 0216 ASL $85
+        0x26, 0x84,         // 0218 ROL $84
+        0x90, 0x0C,         // 021A BCC $0228
+        0xA5, 0x84,         // 021C LDA $84
+        0x49, 0x10,         // 021E EOR #$10
+        0x85, 0x84,         // 0220 STA $84
+        0xA5, 0x85,         // 0222 LDA $85
+        0x49, 0x21,         // 0224 EOR #$21
+        0x85, 0x85,         // 0226 STA $85
+        // next
+        0xCA,               // 0228 DEX
+        0xD0, 0xEB,         // 0229 BNE $0216
+        0xC8,               // 022B INY
+        0xC0, 0x03,         // 022C CPY #$03
+        0xD0, 0xD8,         // 022E BNE $0208
+        0x02,               // 0230 JAM
+    };
+
+    u16 CRC16(const u8* bytes, int size)
+    {
+        u16 crc = 0;
+        for(int i = 0; i < size; i++){
+            crc ^= bytes[i] << 8;
+            for(int bit = 0; bit < 8; bit++){
+                crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+            }
+        }
+        return crc;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int threads = 0, stepCycles = 0;
+    long long maxVisited = 0;
+    std::string routine = "multiply";
+    for(int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        if(i + 1 < argc && arg == "-j"){
+            threads = strtol(argv[++i], nullptr, 0);
+        }else if(i + 1 < argc && arg == "-c"){
+            stepCycles = strtol(argv[++i], nullptr, 0);
+        }else if(i + 1 < argc && arg == "-m"){
+            maxVisited = strtoll(argv[++i], nullptr, 0);
+        }else if(arg == "multiply" || arg == "crc16"){
+            routine = arg;
+        }else{
+            fprintf(stderr, "usage: explore [-j threads] [-c step cycles] [-m max visited in memory] [routine]\n");
+            return 1;
+        }
+    }
+
+    bool multiply = routine == "multiply";
+    std::unique_ptr<DirtyMem> mem(new DirtyMem);
+    FuzzCPU cpu;
+    cpu.Reset(*mem);
+    const u8* program = multiply ? MultiplyProgram : CRC16Program;
+    u32 size = multiply ? sizeof(MultiplyProgram) : sizeof(CRC16Program);
+    for(u32 i = 0; i < size; i++){
+        (*mem)[0x0200 + i] = program[i];
+    }
+    cpu.PC = 0x0200;
+
+    Explorer<> explorer(cpu, *mem, 0x0080, multiply ? 2 : 3);
+    if(threads > 0){
+        explorer.Threads = threads;
+    }
+    if(stepCycles > 0){
+        explorer.StepCycles = stepCycles;
+    }
+    if(maxVisited > 0){
+        explorer.Visited.MaxInMemory = maxVisited;
+    }
+    explorer.Explore();
+
+    // the CRC routine shifts its input out, so every CRC has to show up
+    std::unique_ptr<DirtyMem> final(new DirtyMem);
+    FuzzCPU finalCPU;
+    std::vector<bool> crcs(multiply ? 0 : 0x10000);
+    u64 wrong = 0;
+    for(const auto& state : explorer.Finals){
+        explorer.Load(state, finalCPU, *final);
+        if(multiply){
+            wrong += ((*final)[0x82] | (*final)[0x83] << 8) != (*final)[0x80] * (*final)[0x81];
+        }else{
+            crcs[(*final)[0x84] << 8 | (*final)[0x85]] = true;
+        }
+    }
+    if(!multiply){
+        for(u32 input = 0; input < (1 << 24); input++){
+            u8 bytes[3] = {u8(input), u8(input >> 8), u8(input >> 16)};
+            wrong += !crcs[CRC16(bytes, 3)];
+        }
+    }
+
+    printf("%s, %d threads, %d cycle steps\n", routine.c_str(), explorer.Threads, explorer.StepCycles);
+    printf("inputs       %llu in %.2f s\n", explorer.Inputs, explorer.Seconds);
+    printf("states       %llu distinct, %llu duplicates, %llu steps\n", explorer.States, explorer.Duplicates,
+        explorer.Steps);
+    printf("finals       %zu, %llu unfinished, %llu wrong\n", explorer.Finals.size(), explorer.Unfinished, wrong);
+    printf("speed        %.0f states/s\n", explorer.StatesPerSecond());
+    printf("memory       %.1f bytes/state, %llu distinct pages\n", explorer.BytesPerState(),
+        explorer.Pages->Pages());
+    printf("visited      %llu, %llu spills, %.1f MB on disk\n", explorer.Visited.Size(), explorer.Visited.Spills,
+        explorer.Visited.SpilledBytes() / 1e6);
+    return wrong ? 1 : 0;
+}
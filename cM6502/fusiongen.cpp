@@ -0,0 +1,153 @@
+// Profiles opcode pairs and writes the fusion set header.
+//
+// usage: fusiongen [-n rules] [-o header] [image@load[@entry[@cycles]] ...]
+//
+// Without images the built-in workload corpus is profiled. The header goes
+// to stdout unless -o is given. The throughput of the currently compiled
+// DefaultFusion against plain Execute is printed to stderr.
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "M6502DefaultFusion.h"
+#include "M6502Workloads.h"
+
+using namespace M6502;
+
+namespace
+{
+    template<typename Run>
+    double MHz(const Workload& workload, Mem& mem, Run run)
+    {
+        CPU cpu;
+        workload.Setup(cpu, mem);
+        auto start = std::chrono::steady_clock::now();
+        long long cycles = 0;
+        for(int i = 0; i < 10; i++){
+            cycles += run(cpu, workload.Cycles, mem);
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return cycles / seconds / 1e6;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t maxRules = 16;
+    const char* outPath = nullptr;
+    std::vector<WorkloadImage> programs;
+    for(int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        if(arg == "-n" && i + 1 < argc){
+            maxRules = strtoul(argv[++i], nullptr, 0);
+        }else if(arg == "-o" && i + 1 < argc){
+            outPath = argv[++i];
+        }else{
+            programs.emplace_back();
+            if(!ParseWorkloadImage(arg, programs.back())){
+                fprintf(stderr, "cannot load %s, expected image@load[@entry[@cycles]]\n", arg.c_str());
+                return 1;
+            }
+        }
+    }
+    std::vector<Workload> corpus;
+    for(const WorkloadImage& program : programs){
+        corpus.push_back(program.View());
+    }
+    if(corpus.empty()){
+        corpus.assign(std::begin(CorpusWorkloads), std::end(CorpusWorkloads));
+    }
+
+    std::unique_ptr<Mem> mem(new Mem);
+    std::unique_ptr<OpcodeProfile> profile(new OpcodeProfile);
+    for(const Workload& workload : corpus){
+        CPU cpu;
+        workload.Setup(cpu, *mem);
+        ExecuteProfiled(cpu, workload.Cycles, *mem, *profile);
+        profile->Break();
+    }
+
+    std::vector<std::pair<u64, u32>> pairs;
+    u64 totalPairs = 0;
+    for(u32 i = 0; i < 256 * 256; i++){
+        totalPairs += profile->Pairs[i];
+        if(profile->Pairs[i]){
+            pairs.push_back({profile->Pairs[i], i});
+        }
+    }
+    std::sort(pairs.begin(), pairs.end(), [](const auto& a, const auto& b){ return a.first > b.first; });
+    if(pairs.size() > maxRules){
+        pairs.resize(maxRules);
+    }
+
+    // one rule per first opcode, seconds in order of frequency
+    std::map<u8, std::vector<std::pair<u64, u8>>> rules;
+    for(const auto& pair : pairs){
+        rules[pair.second >> 8].push_back({pair.first, pair.second & 0xFF});
+    }
+    std::vector<std::pair<u64, u8>> order;
+    for(const auto& rule : rules){
+        u64 count = 0;
+        for(const auto& second : rule.second){
+            count += second.first;
+        }
+        order.push_back({count, rule.first});
+    }
+    std::sort(order.begin(), order.end(), [](const auto& a, const auto& b){ return a.first > b.first; });
+
+    std::string header =
+        "// Generated by fusiongen from";
+    for(const Workload& workload : corpus){
+        header += " ";
+        header += workload.Name;
+    }
+    header +=
+        ", do not edit.\n"
+        "#ifndef M6502_DEFAULT_FUSION_H\n"
+        "#define M6502_DEFAULT_FUSION_H\n"
+        "#include \"M6502Fusion.h\"\n"
+        "\n"
+        "namespace M6502\n"
+        "{\n"
+        "    // share of all executed opcode pairs in the comments\n"
+        "    using DefaultFusion = FusionSet<";
+    for(size_t i = 0; i < order.size(); i++){
+        char line[64];
+        snprintf(line, sizeof(line), "\n        Fuse<0x%02X", order[i].second);
+        header += line;
+        for(const auto& second : rules[order[i].second]){
+            snprintf(line, sizeof(line), ", 0x%02X", second.second);
+            header += line;
+        }
+        snprintf(line, sizeof(line), ">%s  // %.2f%%", i + 1 < order.size() ? "," : "",
+            100.0 * order[i].first / totalPairs);
+        header += line;
+    }
+    header +=
+        "\n"
+        "    >;\n"
+        "}\n"
+        "#endif\n";
+
+    if(outPath){
+        std::ofstream out(outPath);
+        out << header;
+    }else{
+        fputs(header.c_str(), stdout);
+    }
+
+    for(const Workload& workload : corpus){
+        double plain = MHz(workload, *mem, [](CPU& cpu, int cycles, Mem& mem){
+            return cpu.Execute(cycles, mem);
+        });
+        double fused = MHz(workload, *mem, [](CPU& cpu, int cycles, Mem& mem){
+            return ExecuteFused<DefaultFusion>(cpu, cycles, mem);
+        });
+        fprintf(stderr, "%-12s %8.1f MHz plain  %8.1f MHz fused  %+6.1f%%\n",
+            workload.Name, plain, fused, 100.0 * (fused - plain) / plain);
+    }
+    return 0;
+}
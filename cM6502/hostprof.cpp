@@ -0,0 +1,164 @@
+// Ranks opcode handlers, mnemonics and operand modes by host cost per
+// emulated instruction, measured with perf_event counters.
+//
+// usage: hostprof [-w window] [-p period] [-n rows] [image@load[@entry[@cycles]] ...]
+//
+// Without images the built-in workload corpus is run. -w and -p set how
+// many instructions of every period are measured, see M6502HostCounters.h.
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include "M6502HostCounters.h"
+#include "M6502Opcodes.h"
+#include "M6502Workloads.h"
+
+using namespace M6502;
+
+namespace
+{
+    // a set of opcodes reported as one row
+    struct Group{
+        std::string name;
+        bool opcodes[256] = {};
+        u64 executed = 0;
+        u64 sampled = 0;
+        double cost[HostProfile::COUNTERS] = {};
+    };
+
+    void AddOpcode(Group& group, const HostProfile& profile, u8 opcode)
+    {
+        group.opcodes[opcode] = true;
+        group.executed += profile.Executed[opcode];
+        group.sampled += profile.Sampled[opcode];
+    }
+
+    void PrintGroups(const char* title, std::vector<Group>& groups, const HostProfile& profile, size_t rows)
+    {
+        u64 total = 0;
+        for(Group& group : groups){
+            total += group.executed;
+            for(int c = 0; c < profile.Counters.Opened; c++){
+                group.cost[c] = profile.PerInstruction(group.opcodes, c);
+            }
+        }
+        groups.erase(std::remove_if(groups.begin(), groups.end(), [](const Group& group){
+            return group.sampled == 0;
+        }), groups.end());
+        std::sort(groups.begin(), groups.end(), [](const Group& a, const Group& b){
+            return a.cost[0] > b.cost[0];
+        });
+
+        printf("\n%s\n%-16s %12s %7s %9s", title, "", "executed", "share", "samples");
+        for(int c = 0; c < profile.Counters.Opened; c++){
+            printf(" %14s", profile.Counters.Names[c]);
+        }
+        printf("\n");
+        for(size_t i = 0; i < groups.size() && i < rows; i++){
+            const Group& group = groups[i];
+            printf("%-16s %12llu %6.2f%% %9llu", group.name.c_str(), group.executed,
+                100.0 * group.executed / total, group.sampled);
+            for(int c = 0; c < profile.Counters.Opened; c++){
+                printf(" %14.2f", group.cost[c]);
+            }
+            printf("\n");
+        }
+    }
+
+    template<typename Run>
+    double MHz(const std::vector<Workload>& corpus, Mem& mem, Run run)
+    {
+        auto start = std::chrono::steady_clock::now();
+        long long cycles = 0;
+        for(const Workload& workload : corpus){
+            CPU cpu;
+            workload.Setup(cpu, mem);
+            cycles += run(cpu, workload.Cycles, mem);
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return cycles / seconds / 1e6;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::unique_ptr<HostProfile> profile(new HostProfile);
+    size_t rows = 20;
+    std::vector<WorkloadImage> programs;
+    for(int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        if(arg == "-w" && i + 1 < argc){
+            profile->Window = strtol(argv[++i], nullptr, 0);
+        }else if(arg == "-p" && i + 1 < argc){
+            profile->Period = strtol(argv[++i], nullptr, 0);
+        }else if(arg == "-n" && i + 1 < argc){
+            rows = strtoul(argv[++i], nullptr, 0);
+        }else{
+            programs.emplace_back();
+            if(!ParseWorkloadImage(arg, programs.back())){
+                fprintf(stderr, "cannot load %s, expected image@load[@entry[@cycles]]\n", arg.c_str());
+                return 1;
+            }
+        }
+    }
+    std::vector<Workload> corpus;
+    for(const WorkloadImage& program : programs){
+        corpus.push_back(program.View());
+    }
+    if(corpus.empty()){
+        corpus.assign(std::begin(CorpusWorkloads), std::end(CorpusWorkloads));
+    }
+
+    const HostCounters& counters = profile->Counters;
+    if(counters.Opened == 0){
+        fprintf(stderr, "perf_event_open failed, no host counters available\n");
+        return 1;
+    }
+    profile->Calibrate();
+
+    std::unique_ptr<Mem> mem(new Mem);
+    double plain = MHz(corpus, *mem, [](CPU& cpu, int cycles, Mem& mem){
+        return cpu.Execute(cycles, mem);
+    });
+    double counted = MHz(corpus, *mem, [&](CPU& cpu, int cycles, Mem& mem){
+        return ExecuteCounted(cpu, cycles, mem, *profile);
+    });
+
+    printf("counters:");
+    for(int c = 0; c < counters.Opened; c++){
+        printf(" %s", counters.Names[c]);
+    }
+    printf(counters.Hardware ? " (hardware)\n" : " (no hardware counters, software clock)\n");
+    printf("measured %d of every %d instructions, read overhead of %.1f %s taken off\n",
+        profile->Window, profile->Period, profile->Overhead[0], counters.Names[0]);
+    printf("%.1f MHz plain, %.1f MHz counted (%+.1f%%)\n", plain, counted, 100.0 * (counted - plain) / plain);
+
+    std::vector<Group> handlers(256);
+    std::vector<Group> mnemonics;
+    std::vector<Group> modes(OpcodeInfo::MODES);
+    for(int i = 0; i < 256; i++){
+        const OpcodeInfo& info = OpcodeInfo::Of<CPU>(i);
+        char name[32];
+        snprintf(name, sizeof(name), "%02X %s %s", i, info.Mnemonic, OpcodeInfo::ModeName(info.Operand));
+        handlers[i].name = name;
+        AddOpcode(handlers[i], *profile, i);
+
+        auto mnemonic = std::find_if(mnemonics.begin(), mnemonics.end(), [&](const Group& group){
+            return group.name == info.Mnemonic;
+        });
+        if(mnemonic == mnemonics.end()){
+            mnemonics.emplace_back();
+            mnemonic = mnemonics.end() - 1;
+            mnemonic->name = info.Mnemonic;
+        }
+        AddOpcode(*mnemonic, *profile, i);
+
+        modes[info.Operand].name = OpcodeInfo::ModeName(info.Operand);
+        AddOpcode(modes[info.Operand], *profile, i);
+    }
+    PrintGroups("handlers by host cost per instruction", handlers, *profile, rows);
+    PrintGroups("mnemonics by host cost per instruction", mnemonics, *profile, rows);
+    PrintGroups("operand modes by host cost per instruction", modes, *profile, rows);
+    return 0;
+}
@@ -0,0 +1,112 @@
+// Resident memory and throughput of many CPU/Mem instances.
+//
+// usage: memdensity [instances...]
+//
+// Every instance runs the same small fill loop that touches three pages,
+// round robin, with both the flat Mem and SparseMem. Each measurement runs in
+// its own child process so the resident set starts clean.
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "cM6502.h"
+
+using M6502::u8;
+
+namespace
+{
+    const u8 Program[] = {
+        0xA2, 0x00,         // LDX #0
+        0x8A,               // TXA
+        0x9D, 0x00, 0x03,   // STA $0300,X
+        0xE8,               // INX
+        0xD0, 0xF9,         // BNE $0202
+        0xE6, 0x10,         // INC $10
+        0x4C, 0x00, 0x02,   // JMP $0200
+    };
+
+    long ResidentKB()
+    {
+        long pages = 0, resident = 0;
+        FILE* statm = fopen("/proc/self/statm", "r");
+        if(statm){
+            if(fscanf(statm, "%ld %ld", &pages, &resident) != 2){
+                resident = 0;
+            }
+            fclose(statm);
+        }
+        return resident * 4;
+    }
+
+    template<typename MemType>
+    void Measure(const char* name, size_t instances)
+    {
+        using CPUType = M6502::BasicCPU<M6502::NMOS6502, MemType>;
+        struct Instance{
+            CPUType cpu;
+            MemType mem;
+        };
+        long before = ResidentKB();
+        std::vector<std::unique_ptr<Instance>> machines;
+        machines.reserve(instances);
+        for(size_t i = 0; i < instances; i++){
+            machines.emplace_back(new Instance);
+            Instance& machine = *machines.back();
+            machine.cpu.Reset(machine.mem);
+            for(size_t j = 0; j < sizeof(Program); j++){
+                machine.mem[0x0200 + j] = Program[j];
+            }
+            machine.cpu.PC = 0x0200;
+        }
+
+        constexpr int SLICE = 1000;
+        long long cycles = 0;
+        auto start = std::chrono::steady_clock::now();
+        for(int round = 0; round < 20; round++){
+            for(auto& machine : machines){
+                cycles += machine->cpu.Execute(SLICE, machine->mem);
+            }
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        long after = ResidentKB();
+
+        printf("%-6s %8zu instances  %9.1f MB resident  %7.2f KB/instance  %8.1f emulated MHz\n",
+            name, instances, (after - before) / 1024.0, double(after - before) / instances,
+            cycles / seconds / 1e6);
+    }
+
+    template<typename MemType>
+    void MeasureInChild(const char* name, size_t instances)
+    {
+        fflush(stdout);
+        pid_t child = fork();
+        if(child == 0){
+            Measure<MemType>(name, instances);
+            fflush(stdout);
+            _exit(0);
+        }
+        int status = 0;
+        waitpid(child, &status, 0);
+        if(!WIFEXITED(status)){
+            printf("%-6s %8zu instances  did not finish (out of memory?)\n", name, instances);
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<size_t> counts;
+    for(int i = 1; i < argc; i++){
+        counts.push_back(strtoul(argv[i], nullptr, 0));
+    }
+    if(counts.empty()){
+        counts = {1000, 10000, 100000};
+    }
+    for(size_t count : counts){
+        MeasureInChild<M6502::SparseMem>("sparse", count);
+        MeasureInChild<M6502::Mem>("flat", count);
+    }
+    return 0;
+}
@@ -0,0 +1,66 @@
+// Runs a corpus workload in real time at a target frequency and reports how
+// well the pacing held.
+//
+// usage: pace [-f MHz] [-b burst] [-s spin] [-t seconds] [workload]
+//
+// -f is the target frequency in MHz, 1 by default (1.79 for NTSC, 2 ...),
+// -b the cycles per burst, 1000 by default, and -s how many microseconds
+// before each deadline the sleep ends and spinning starts, 100 by default.
+// -s 0 only sleeps, to compare against. The workload is named from the
+// corpus, the first one by default.
+#include <memory>
+#include <string>
+#include "M6502Pacing.h"
+#include "M6502Workloads.h"
+
+using namespace M6502;
+
+int main(int argc, char** argv)
+{
+    Pacer pacer;
+    double seconds = 2;
+    const Workload* workload = &CorpusWorkloads[0];
+    for(int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        if(i + 1 < argc && arg == "-f"){
+            pacer.Frequency = strtod(argv[++i], nullptr) * 1e6;
+        }else if(i + 1 < argc && arg == "-b"){
+            pacer.BurstCycles = strtol(argv[++i], nullptr, 0);
+        }else if(i + 1 < argc && arg == "-s"){
+            pacer.Spin = static_cast<long long>(strtod(argv[++i], nullptr) * 1000);
+        }else if(i + 1 < argc && arg == "-t"){
+            seconds = strtod(argv[++i], nullptr);
+        }else{
+            workload = nullptr;
+            for(const Workload& corpus : CorpusWorkloads){
+                if(arg == corpus.Name){
+                    workload = &corpus;
+                }
+            }
+            if(!workload){
+                break;
+            }
+        }
+    }
+    if(!workload || !(pacer.Frequency > 0) || pacer.BurstCycles <= 0 || !(seconds > 0)){
+        fprintf(stderr, "usage: pace [-f MHz] [-b burst] [-s spin] [-t seconds] [workload]\n");
+        return 1;
+    }
+
+    std::unique_ptr<Mem> mem(new Mem);
+    CPU cpu;
+    workload->Setup(cpu, *mem);
+    pacer.Run(cpu, *mem, static_cast<long long>(pacer.Frequency * seconds));
+
+    const PacingStats& stats = pacer.Stats;
+    printf("%s at %.3f MHz, %d cycle bursts, %lld us spin\n", workload->Name, pacer.Frequency / 1e6,
+        pacer.BurstCycles, pacer.Spin / 1000);
+    printf("achieved     %.6f MHz (%+.4f%%)\n", stats.Frequency() / 1e6,
+        100 * (stats.Frequency() - pacer.Frequency) / pacer.Frequency);
+    printf("late by      p50 %.1f us  p90 %.1f us  p99 %.1f us  p99.9 %.1f us  max %.1f us\n",
+        stats.Jitter(50) / 1e3, stats.Jitter(90) / 1e3, stats.Jitter(99) / 1e3, stats.Jitter(99.9) / 1e3,
+        stats.Jitter(100) / 1e3);
+    printf("host CPU     %.1f%% busy, %.1f%% emulating\n", 100 * stats.Utilisation(), 100 * stats.Load());
+    printf("bursts       %llu, %llu resyncs\n", stats.Bursts, stats.Resyncs);
+    return 0;
+}
@@ -0,0 +1,87 @@
+// Runs the benchmark programs segment by segment, once in order and once
+// speculatively from recorded predictions, and reports the speedup and how
+// many predictions were wrong.
+//
+// usage: speculate [-j threads] [-c segment cycles] [-p address]
+//
+// -j is the number of worker threads, the host's cores by default, -c the
+// cycles per segment, 1000000 by default. With -p the predictions are
+// recorded with the byte at address changed, so they miss wherever that
+// byte is still in memory. Workloads driven by IRQs are left out, their
+// interrupts fall between segments.
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <string>
+#include "M6502Speculate.h"
+#include "M6502Workloads.h"
+
+using namespace M6502;
+
+static double Seconds(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv)
+{
+    Speculator<> speculator;
+    long perturb = -1;
+    for(int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        if(i + 1 < argc && arg == "-j"){
+            speculator.Threads = strtol(argv[++i], nullptr, 0);
+        }else if(i + 1 < argc && arg == "-c"){
+            speculator.SegmentCycles = strtol(argv[++i], nullptr, 0);
+        }else if(i + 1 < argc && arg == "-p"){
+            perturb = strtol(argv[++i], nullptr, 0) & 0xFFFF;
+        }else{
+            fprintf(stderr, "usage: speculate [-j threads] [-c segment cycles] [-p address]\n");
+            return 1;
+        }
+    }
+    if(speculator.Threads < 1 || speculator.SegmentCycles < 1){
+        fprintf(stderr, "usage: speculate [-j threads] [-c segment cycles] [-p address]\n");
+        return 1;
+    }
+
+    printf("%d threads, %d cycle segments\n", speculator.Threads, speculator.SegmentCycles);
+    printf("%-12s %9s %9s %8s %9s %12s\n", "workload", "plain ms", "spec ms", "speedup", "segments", "mispredicted");
+    bool failed = false;
+    for(const Workload& workload : BenchmarkWorkloads){
+        if(workload.IRQPeriod > 0){
+            continue;
+        }
+        std::unique_ptr<Mem> mem(new Mem);
+        CPU cpu;
+
+        workload.Setup(cpu, *mem);
+        if(perturb >= 0){
+            (*mem)[perturb] ^= 0xFF;
+        }
+        Speculator<>::States predicted = speculator.Record(cpu, *mem, workload.Cycles);
+
+        workload.Setup(cpu, *mem);
+        auto start = std::chrono::steady_clock::now();
+        for(size_t i = 0; i < speculator.Count(workload.Cycles); i++){
+            cpu.Execute(speculator.SegmentCycles, *mem);
+        }
+        double plain = Seconds(start);
+        CPU expected = cpu;
+        std::unique_ptr<Mem> expectedMem(new Mem(*mem));
+
+        workload.Setup(cpu, *mem);
+        start = std::chrono::steady_clock::now();
+        speculator.Run(cpu, *mem, workload.Cycles, predicted);
+        double speculative = Seconds(start);
+
+        bool same = cpu.PC == expected.PC && cpu.A == expected.A && cpu.X == expected.X &&
+                    cpu.Y == expected.Y && cpu.GetStatus() == expected.GetStatus() &&
+                    memcmp(mem->data, expectedMem->data, Mem::MAX_MEM) == 0;
+        failed |= !same;
+        printf("%-12s %9.2f %9.2f %7.2fx %9llu %11.1f%%%s\n", workload.Name, plain * 1e3, speculative * 1e3,
+            plain / speculative, speculator.Segments, 100 * speculator.MispredictionRate(),
+            same ? "" : "  DIFFERENT STATE");
+    }
+    return failed ? 1 : 0;
+}